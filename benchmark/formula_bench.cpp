@@ -0,0 +1,232 @@
+/**
+ * 合成公式基准测试 - 主程序
+ * 在 formula_generator 生成的数据集上运行识别器, 统计吞吐量、各阶段耗时与字符/表达式准确率
+ * (识别内部阶段: 预处理、行检测、分割、分类、计算; 多公式模式下行内阶段为各行之和)
+ */
+
+#include "formula_recognizer.h"
+#include "formula_json.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+
+// 一张图片的标准答案
+struct TruthEntry {
+    string file;
+    vector<string> expressions;
+    vector<double> values;
+};
+
+static vector<string> splitList(const string& joined) {
+    vector<string> items;
+    string item;
+    stringstream ss(joined);
+    while (getline(ss, item, ';')) {
+        items.push_back(item);
+    }
+    return items;
+}
+
+static bool loadTruth(const string& path, vector<TruthEntry>& entries) {
+    ifstream in(path);
+    if (!in.is_open()) {
+        return false;
+    }
+
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        stringstream ss(line);
+        string joined_expr, joined_values;
+        TruthEntry entry;
+        ss >> entry.file >> joined_expr >> joined_values;
+        entry.expressions = splitList(joined_expr);
+        for (const auto& v : splitList(joined_values)) {
+            entry.values.push_back(atof(v.c_str()));
+        }
+        if (!entry.file.empty()) {
+            entries.push_back(entry);
+        }
+    }
+    return true;
+}
+
+// 编辑距离(字符级错误数)
+static int editDistance(const string& a, const string& b) {
+    vector<int> prev(b.size() + 1), cur(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); j++) prev[j] = (int)j;
+    for (size_t i = 1; i <= a.size(); i++) {
+        cur[0] = (int)i;
+        for (size_t j = 1; j <= b.size(); j++) {
+            int substitute = prev[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1);
+            cur[j] = min(substitute, min(prev[j], cur[j - 1]) + 1);
+        }
+        swap(prev, cur);
+    }
+    return prev[b.size()];
+}
+
+static void printUsage(const char* program_name) {
+    cout << "合成公式基准测试" << endl;
+    cout << endl;
+    cout << "用法: " << program_name << " <数据集目录> [选项]" << endl;
+    cout << endl;
+    cout << "选项:" << endl;
+    cout << "  --single                 单公式识别模式(默认多公式)" << endl;
+    cout << "  --limit <N>              只测试前 N 张图片" << endl;
+    cout << "  --show-errors <N>        列出前 N 个识别错误的公式(默认 10)" << endl;
+    cout << "  --min-char-accuracy <比例>  字符准确率低于该值时返回非零退出码" << endl;
+    cout << endl;
+    cout << "数据集由 formula_generator 生成, 目录中需包含 ground_truth.txt" << endl;
+    cout << endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return -1;
+    }
+
+    string dataset_dir = argv[1];
+    bool multi_mode = true;
+    size_t limit = 0;
+    int show_errors = 10;
+    double min_char_accuracy = -1.0;
+
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--single") {
+            multi_mode = false;
+        } else if (arg == "--limit" && i + 1 < argc) {
+            limit = (size_t)max(0, atoi(argv[++i]));
+        } else if (arg == "--show-errors" && i + 1 < argc) {
+            show_errors = max(0, atoi(argv[++i]));
+        } else if (arg == "--min-char-accuracy" && i + 1 < argc) {
+            min_char_accuracy = atof(argv[++i]);
+        } else {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+
+    vector<TruthEntry> entries;
+    if (!loadTruth(dataset_dir + "/ground_truth.txt", entries) || entries.empty()) {
+        cerr << "错误: 无法读取标准答案 " << dataset_dir << "/ground_truth.txt" << endl;
+        return -1;
+    }
+    if (limit > 0 && entries.size() > limit) {
+        entries.resize(limit);
+    }
+
+    FormulaRecognizer recognizer;
+    recognizer.setVerbose(false);
+
+    double decode_ms = 0, recognize_ms = 0, serialize_ms = 0;
+    RecognitionProfile profile;  // 识别器内部各阶段耗时
+    int images = 0, unreadable = 0;
+    int total_chars = 0, char_errors = 0;
+    int total_expressions = 0, correct_expressions = 0, correct_values = 0;
+    int errors_shown = 0;
+
+    for (const auto& entry : entries) {
+        TickMeter tm;
+        tm.start();
+        Mat image = imread(dataset_dir + "/" + entry.file);
+        tm.stop();
+        if (image.empty()) {
+            unreadable++;
+            continue;
+        }
+        decode_ms += tm.getTimeMilli();
+
+        tm.reset();
+        tm.start();
+        vector<FormulaResult> results;
+        if (multi_mode) {
+            results = recognizer.recognizeMultipleFormulas(image, &profile);
+        } else {
+            results.push_back(recognizer.recognizeFormula(image, &profile));
+        }
+        tm.stop();
+        recognize_ms += tm.getTimeMilli();
+
+        tm.reset();
+        tm.start();
+        string json = imageResultsToJson(entry.file, results);
+        tm.stop();
+        serialize_ms += tm.getTimeMilli();
+        images++;
+
+        // 按顺序逐个对比; 缺失的行整行计错, 多出的行按其长度计错
+        size_t n = max(entry.expressions.size(), results.size());
+        for (size_t i = 0; i < n; i++) {
+            string want = i < entry.expressions.size() ? entry.expressions[i] : "";
+            string got = i < results.size() ? results[i].expression : "";
+            int errors = editDistance(want, got);
+            total_chars += (int)want.size();
+            char_errors += errors;
+            if (want.empty()) continue;
+
+            total_expressions++;
+            if (errors == 0) correct_expressions++;
+            if (i < results.size() && i < entry.values.size() &&
+                fabs(results[i].result - entry.values[i]) < 1e-6) {
+                correct_values++;
+            }
+            if (errors > 0 && errors_shown < show_errors) {
+                cout << "✗ " << entry.file << " #" << (i + 1) << ": 期望 " << want
+                     << ", 识别 " << (got.empty() ? "(无)" : got) << endl;
+                errors_shown++;
+            }
+        }
+    }
+
+    if (images == 0) {
+        cerr << "错误: 数据集中没有可读取的图片" << endl;
+        return -1;
+    }
+
+    double char_accuracy = total_chars > 0 ? 1.0 - (double)char_errors / total_chars : 0.0;
+    if (char_accuracy < 0) char_accuracy = 0;
+
+    cout << endl;
+    cout << "========== 合成公式基准 ==========" << endl;
+    cout << "图片: " << images << " 张 (" << (multi_mode ? "多公式" : "单公式") << "模式)";
+    if (unreadable > 0) cout << ", 无法读取 " << unreadable << " 张";
+    cout << endl;
+    cout << fixed << setprecision(1);
+    cout << "吞吐量: " << images / (recognize_ms / 1000.0) << " images/s (仅识别), "
+         << images / ((decode_ms + recognize_ms + serialize_ms) / 1000.0) << " images/s (含解码与序列化)"
+         << endl;
+    cout << setprecision(3);
+    cout << "阶段耗时 (每张平均):" << endl;
+    cout << "  解码     " << setw(9) << decode_ms / images << " ms" << endl;
+    cout << "  识别     " << setw(9) << recognize_ms / images << " ms" << endl;
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        RecognitionStage stage = static_cast<RecognitionStage>(s);
+        if (stage == STAGE_RENDERING) continue;
+        cout << "    " << left << setw(16) << RecognitionProfile::stageName(stage) << right
+             << setw(9) << profile.stage_ms[s] / images << " ms" << endl;
+    }
+    cout << "  序列化   " << setw(9) << serialize_ms / images << " ms" << endl;
+    cout << setprecision(2);
+    cout << "字符准确率: " << char_accuracy * 100.0 << "% (" << char_errors << " 处错误 / "
+         << total_chars << " 个字符)" << endl;
+    cout << "表达式准确率: " << (total_expressions > 0 ? 100.0 * correct_expressions / total_expressions : 0.0)
+         << "% (" << correct_expressions << "/" << total_expressions << ")" << endl;
+    cout << "计算结果准确率: " << (total_expressions > 0 ? 100.0 * correct_values / total_expressions : 0.0)
+         << "% (" << correct_values << "/" << total_expressions << ")" << endl;
+
+    if (min_char_accuracy >= 0 && char_accuracy < min_char_accuracy) {
+        cout << "✗ 字符准确率低于阈值 " << min_char_accuracy * 100.0 << "%" << endl;
+        return 1;
+    }
+    return 0;
+}
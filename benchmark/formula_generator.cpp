@@ -0,0 +1,344 @@
+/**
+ * 合成公式图片生成器
+ * 随机生成合法表达式(数字、+ - x ÷、括号、根号、=)并渲染成页面, 同时写出标准答案,
+ * 用于公式识别的吞吐量与准确率压力测试(配合 formula_bench)
+ */
+
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <sys/stat.h>
+
+using namespace cv;
+using namespace std;
+
+// 96 DPI、字号倍率 1.0 时的数字高度(像素), 与 formula_images 中的样本接近
+static const double kBaseGlyphHeight = 30.0;
+
+// 生成选项
+struct GeneratorOptions {
+    string output_dir;
+    int count;             // 页面数
+    int rows;              // 每页公式行数
+    int cols;              // 每页公式列数
+    int dpi;               // 分辨率(96 为基准)
+    double font_scale;     // 字号倍率
+    double noise;          // 高斯噪声标准差(灰度级)
+    double speckle;        // 椒盐噪声密度(0~1)
+    uint64_t seed;
+
+    GeneratorOptions()
+        : output_dir("synthetic_formulas"), count(100), rows(1), cols(1), dpi(96),
+          font_scale(1.0), noise(0.0), speckle(0.0), seed(12345) {}
+};
+
+// ============================================================================
+// 表达式生成与求值
+// 字符集与识别输出一致: x 乘, / 除, s 根号(后跟完全平方数)
+// ============================================================================
+
+static string randomNumber(RNG& rng) {
+    int digits = rng.uniform(0, 10) < 6 ? 2 : (rng.uniform(0, 2) == 0 ? 1 : 3);
+    int lo = digits == 1 ? 1 : (digits == 2 ? 10 : 100);
+    return to_string(rng.uniform(lo, lo * 10));
+}
+
+// 因子: 数字 / 根号 / 括号子表达式(仅在 depth > 0 时)
+static string randomExpression(RNG& rng, int depth);
+
+static string randomFactor(RNG& rng, int depth) {
+    int kind = rng.uniform(0, 10);
+    if (kind == 0) {
+        int root = rng.uniform(2, 13);
+        return "s" + to_string(root * root);
+    }
+    if (kind == 1 && depth > 0) {
+        return "(" + randomExpression(rng, depth - 1) + ")";
+    }
+    return randomNumber(rng);
+}
+
+// 项: 因子 [x 因子] 或 被除数/除数(整除, 除数为 2~12)
+static string randomTerm(RNG& rng, int depth) {
+    int kind = rng.uniform(0, 10);
+    if (kind < 2) {
+        int divisor = rng.uniform(2, 13);
+        int quotient = rng.uniform(1, 50);
+        return to_string(divisor * quotient) + "/" + to_string(divisor);
+    }
+    if (kind < 4) {
+        return randomFactor(rng, depth) + "x" + randomFactor(rng, depth);
+    }
+    return randomFactor(rng, depth);
+}
+
+static string randomExpression(RNG& rng, int depth) {
+    string expr = randomTerm(rng, depth);
+    int terms = rng.uniform(1, 4);
+    for (int i = 1; i < terms; i++) {
+        expr += (rng.uniform(0, 2) == 0 ? "+" : "-") + randomTerm(rng, depth);
+    }
+    return expr;
+}
+
+// 递归下降求值(独立于识别器, 作为标准答案)
+class ExpressionEvaluator {
+private:
+    const string& text;
+    size_t pos;
+
+    double factor() {
+        if (pos < text.size() && text[pos] == '(') {
+            pos++;
+            double value = expression();
+            pos++;  // ')'
+            return value;
+        }
+        bool root = pos < text.size() && text[pos] == 's';
+        if (root) pos++;
+        double value = 0;
+        while (pos < text.size() && isdigit((unsigned char)text[pos])) {
+            value = value * 10 + (text[pos++] - '0');
+        }
+        return root ? sqrt(value) : value;
+    }
+
+    double term() {
+        double value = factor();
+        while (pos < text.size() && (text[pos] == 'x' || text[pos] == '/')) {
+            char op = text[pos++];
+            double rhs = factor();
+            value = op == 'x' ? value * rhs : value / rhs;
+        }
+        return value;
+    }
+
+public:
+    explicit ExpressionEvaluator(const string& t) : text(t), pos(0) {}
+
+    double expression() {
+        double value = term();
+        while (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+            char op = text[pos++];
+            double rhs = term();
+            value = op == '+' ? value + rhs : value - rhs;
+        }
+        return value;
+    }
+};
+
+// ============================================================================
+// 渲染: 数字与 + - = ( ) 用 Hershey 字体, x ÷ 根号手工绘制
+// ============================================================================
+
+// 单个字形的宽度(像素)
+static int glyphWidth(char c, double height, int thickness) {
+    switch (c) {
+        case 'x': case '/': return cvRound(height * 0.6);
+        case 's': return cvRound(height * 0.8);
+        default: {
+            int baseline = 0;
+            Size size = getTextSize(string(1, c), FONT_HERSHEY_SIMPLEX,
+                                    height / 22.0, thickness, &baseline);
+            return size.width;
+        }
+    }
+}
+
+// 在 (x, baseline) 处绘制字形, 字形高度为 height
+static void drawGlyph(Mat& page, char c, int x, int baseline, double height, int thickness) {
+    const Scalar ink(0);
+    int w = glyphWidth(c, height, thickness);
+    int top = baseline - cvRound(height);
+    int mid = baseline - cvRound(height * 0.5);
+
+    if (c == 'x') {
+        int m = cvRound(height * 0.25);
+        line(page, Point(x, mid - m), Point(x + w, mid + m), ink, thickness, LINE_AA);
+        line(page, Point(x, mid + m), Point(x + w, mid - m), ink, thickness, LINE_AA);
+    } else if (c == '/') {
+        int r = max(1, cvRound(thickness * 0.8));
+        int gap = cvRound(height * 0.25);
+        line(page, Point(x, mid), Point(x + w, mid), ink, thickness, LINE_AA);
+        circle(page, Point(x + w / 2, mid - gap), r, ink, FILLED, LINE_AA);
+        circle(page, Point(x + w / 2, mid + gap), r, ink, FILLED, LINE_AA);
+    } else if (c == 's') {
+        // 短勾 + 长斜线, 与样本一致不画横线
+        int bottom = baseline + cvRound(height * 0.05);
+        int ceiling = top - cvRound(height * 0.35);
+        Point p0(x, mid + cvRound(height * 0.05));
+        Point p1(x + w / 5, mid - cvRound(height * 0.05));
+        Point p2(x + w / 2, bottom);
+        Point p3(x + w, ceiling);
+        line(page, p0, p1, ink, thickness, LINE_AA);
+        line(page, p1, p2, ink, thickness, LINE_AA);
+        line(page, p2, p3, ink, thickness, LINE_AA);
+    } else {
+        putText(page, string(1, c), Point(x, baseline), FONT_HERSHEY_SIMPLEX,
+                height / 22.0, ink, thickness, LINE_AA);
+    }
+}
+
+// 表达式总宽度; 字形间距小于识别器的列间隙阈值
+static int expressionWidth(const string& expr, double height, int thickness, int spacing) {
+    int width = 0;
+    for (char c : expr) {
+        width += glyphWidth(c, height, thickness) + spacing;
+    }
+    return width - spacing;
+}
+
+static bool makeDirectory(const string& dir) {
+    struct stat st;
+    if (stat(dir.c_str(), &st) == 0) return S_ISDIR(st.st_mode);
+    return mkdir(dir.c_str(), 0755) == 0;
+}
+
+static void printUsage(const char* program_name) {
+    cout << "合成公式图片生成器" << endl;
+    cout << endl;
+    cout << "用法: " << program_name << " [选项]" << endl;
+    cout << endl;
+    cout << "选项:" << endl;
+    cout << "  --out <目录>         输出目录(默认 synthetic_formulas), 标准答案写入 ground_truth.txt" << endl;
+    cout << "  --count <N>          页面数(默认 100)" << endl;
+    cout << "  --rows <N>           每页公式行数(默认 1)" << endl;
+    cout << "  --cols <N>           每页公式列数(默认 1)" << endl;
+    cout << "  --dpi <N>            分辨率, 96 时数字高约 30 像素(默认 96)" << endl;
+    cout << "  --font-scale <倍率>  字号倍率(默认 1.0)" << endl;
+    cout << "  --noise <σ>          高斯噪声标准差, 灰度级(默认 0)" << endl;
+    cout << "  --speckle <密度>     椒盐噪声密度 0~1(默认 0)" << endl;
+    cout << "  --seed <N>           随机种子(默认 12345, 相同参数生成相同数据集)" << endl;
+    cout << endl;
+}
+
+int main(int argc, char** argv) {
+    GeneratorOptions options;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc) {
+            options.output_dir = argv[++i];
+        } else if (arg == "--count" && i + 1 < argc) {
+            options.count = max(1, atoi(argv[++i]));
+        } else if (arg == "--rows" && i + 1 < argc) {
+            options.rows = max(1, atoi(argv[++i]));
+        } else if (arg == "--cols" && i + 1 < argc) {
+            options.cols = max(1, atoi(argv[++i]));
+        } else if (arg == "--dpi" && i + 1 < argc) {
+            options.dpi = max(24, atoi(argv[++i]));
+        } else if (arg == "--font-scale" && i + 1 < argc) {
+            options.font_scale = max(0.25, atof(argv[++i]));
+        } else if (arg == "--noise" && i + 1 < argc) {
+            options.noise = max(0.0, atof(argv[++i]));
+        } else if (arg == "--speckle" && i + 1 < argc) {
+            options.speckle = min(1.0, max(0.0, atof(argv[++i])));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = strtoull(argv[++i], nullptr, 10);
+        } else {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (!makeDirectory(options.output_dir)) {
+        cerr << "错误: 无法创建输出目录 " << options.output_dir << endl;
+        return -1;
+    }
+    string truth_path = options.output_dir + "/ground_truth.txt";
+    ofstream truth(truth_path);
+    if (!truth.is_open()) {
+        cerr << "错误: 无法写入标准答案 " << truth_path << endl;
+        return -1;
+    }
+    truth << "# 合成公式标准答案 (formula_generator 生成)" << endl;
+    truth << "# 格式: <图片文件> <表达式1>[;<表达式2>...] <结果1>[;<结果2>...]   (按行从上到下、每行从左到右)" << endl;
+    truth << "# 参数: rows=" << options.rows << " cols=" << options.cols << " dpi=" << options.dpi
+          << " font_scale=" << options.font_scale << " noise=" << options.noise
+          << " speckle=" << options.speckle << " seed=" << options.seed << endl;
+
+    RNG rng(options.seed);
+    double height = kBaseGlyphHeight * options.dpi / 96.0 * options.font_scale;
+    int thickness = max(1, cvRound(height / 10.0));
+    int spacing = max(2, cvRound(height * 0.2));
+    int margin = cvRound(height * 1.5);
+    int row_pitch = cvRound(height * 2.5);       // 行间留白大于根号/括号的上下伸出
+    int col_gap = cvRound(height * 3.0);         // 列间隙远大于字形间距
+
+    for (int page = 0; page < options.count; page++) {
+        // 先生成表达式, 再按最宽的一列排版
+        vector<string> expressions;
+        vector<double> values;
+        vector<int> col_widths(options.cols, 0);
+        for (int r = 0; r < options.rows; r++) {
+            for (int c = 0; c < options.cols; c++) {
+                string expr = randomExpression(rng, 1);
+                values.push_back(ExpressionEvaluator(expr).expression());
+                expr += "=";
+                expressions.push_back(expr);
+                col_widths[c] = max(col_widths[c], expressionWidth(expr, height, thickness, spacing));
+            }
+        }
+
+        int width = 2 * margin + col_gap * (options.cols - 1);
+        for (int w : col_widths) width += w;
+        int page_height = 2 * margin + row_pitch * options.rows;
+        Mat image(page_height, width, CV_8UC1, Scalar(255));
+
+        for (int r = 0; r < options.rows; r++) {
+            int baseline = margin + r * row_pitch + cvRound(height * 1.5);
+            int x0 = margin;
+            for (int c = 0; c < options.cols; c++) {
+                int x = x0;
+                for (char ch : expressions[r * options.cols + c]) {
+                    drawGlyph(image, ch, x, baseline, height, thickness);
+                    x += glyphWidth(ch, height, thickness) + spacing;
+                }
+                x0 += col_widths[c] + col_gap;
+            }
+        }
+
+        if (options.noise > 0) {
+            Mat noise(image.size(), CV_16SC1);
+            randn(noise, Scalar(0), Scalar(options.noise));
+            Mat noisy;
+            image.convertTo(noisy, CV_16SC1);
+            noisy += noise;
+            noisy.convertTo(image, CV_8UC1);
+        }
+        if (options.speckle > 0) {
+            int count = cvRound(options.speckle * image.total());
+            for (int i = 0; i < count; i++) {
+                image.at<uchar>(rng.uniform(0, image.rows), rng.uniform(0, image.cols)) =
+                    rng.uniform(0, 2) == 0 ? 0 : 255;
+            }
+        }
+
+        stringstream name;
+        name << "synth_" << setw(5) << setfill('0') << page << ".png";
+        if (!imwrite(options.output_dir + "/" + name.str(), image)) {
+            cerr << "错误: 无法写入 " << name.str() << endl;
+            return -1;
+        }
+
+        truth << name.str() << " ";
+        for (size_t i = 0; i < expressions.size(); i++) {
+            truth << (i > 0 ? ";" : "") << expressions[i];
+        }
+        truth << " ";
+        for (size_t i = 0; i < values.size(); i++) {
+            truth << (i > 0 ? ";" : "") << setprecision(10) << values[i];
+        }
+        truth << endl;
+    }
+
+    cout << "✓ 已生成 " << options.count << " 张图片 (每张 " << options.rows << "×" << options.cols
+         << " 个公式, 数字高约 " << cvRound(height) << " 像素): " << options.output_dir << endl;
+    return 0;
+}
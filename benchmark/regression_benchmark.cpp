@@ -0,0 +1,474 @@
+/**
+ * 回归基准测试 - 主程序
+ * 对两个子任务运行固定数据集, 校验识别结果并与已保存的性能基线比较
+ */
+
+#include "conveyor_inspector.h"
+#include "frame_tracer.h"
+#include "formula_recognizer.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+using namespace std;
+
+#ifndef BENCH_SOURCE_DIR
+#define BENCH_SOURCE_DIR "."
+#endif
+
+#ifndef BENCH_BINARY_DIR
+#define BENCH_BINARY_DIR "."
+#endif
+
+// 丢弃被测代码的控制台输出
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+// 单项性能指标
+struct Metric {
+    string name;           // 如 "conveyor/1.mp4/fps"
+    double value;
+    bool throughput;       // 吞吐量指标参与回归判定, 阶段耗时仅记录
+};
+
+// 一张公式图片的期望输出
+struct ExpectedFormula {
+    vector<string> expressions;  // 各行表达式
+    vector<string> values;       // 各行计算结果("*" 表示不校验; 为空时整张图片不校验结果)
+    bool pending;                // 尚未支持: 照常校验并报告, 不计入失败
+};
+
+// 期望输出
+struct ExpectedResults {
+    map<string, pair<int, int>> videos;          // 视频 -> (合格品, 次品)
+    map<string, ExpectedFormula> formulas;       // 图片 -> 各行期望
+};
+
+static vector<string> splitList(const string& joined) {
+    vector<string> items;
+    string item;
+    stringstream js(joined);
+    while (getline(js, item, ';')) {
+        items.push_back(item);
+    }
+    return items;
+}
+
+static string joinList(const vector<string>& items) {
+    string joined;
+    for (size_t i = 0; i < items.size(); i++) {
+        joined += (i > 0 ? ";" : "") + items[i];
+    }
+    return joined;
+}
+
+// 计算结果按 4 位小数输出与比较; 无法计算(NaN)输出为 "nan"
+static string formatValue(double value) {
+    if (std::isnan(value)) {
+        return "nan";
+    }
+    stringstream ss;
+    ss << fixed << setprecision(4) << value;
+    string text = ss.str();
+    text.erase(text.find_last_not_of('0') + 1);
+    if (text.back() == '.') text.pop_back();
+    return text == "-0" ? "0" : text;
+}
+
+static bool valueMatches(double value, const string& want) {
+    if (want == "*") {
+        return true;
+    }
+    if (want == "nan") {
+        return std::isnan(value);
+    }
+    double expected = atof(want.c_str());
+    return !std::isnan(value) && fabs(value - expected) <= 1e-4 * max(1.0, fabs(expected));
+}
+
+static bool loadExpected(const string& path, ExpectedResults& expected) {
+    ifstream in(path);
+    if (!in.is_open()) {
+        return false;
+    }
+
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        stringstream ss(line);
+        string kind, file;
+        ss >> kind >> file;
+        if (kind == "video") {
+            int qualified = 0, defective = 0;
+            ss >> qualified >> defective;
+            expected.videos[file] = make_pair(qualified, defective);
+        } else if (kind == "formula" || kind == "pending") {
+            string expressions, values;
+            ss >> expressions >> values;
+            ExpectedFormula formula;
+            formula.expressions = splitList(expressions);
+            formula.values = splitList(values);
+            formula.pending = (kind == "pending");
+            if (!formula.values.empty() && formula.values.size() != formula.expressions.size()) {
+                cerr << "错误: " << file << " 的计算结果数与表达式数不一致" << endl;
+                return false;
+            }
+            expected.formulas[file] = formula;
+        }
+    }
+    return true;
+}
+
+static map<string, double> loadBaseline(const string& path) {
+    map<string, double> baseline;
+    ifstream in(path);
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        stringstream ss(line);
+        string name;
+        double value;
+        if (ss >> name >> value) {
+            baseline[name] = value;
+        }
+    }
+    return baseline;
+}
+
+static bool saveBaseline(const string& path, const vector<Metric>& metrics) {
+    ofstream out(path);
+    if (!out.is_open()) {
+        return false;
+    }
+    out << "# 回归基准性能基线 (由 regression_benchmark 生成, 与机器相关)" << endl;
+    out << "# 吞吐量: fps / images_per_sec; 阶段耗时: *_ms (每帧或每张平均)" << endl;
+    for (const auto& m : metrics) {
+        out << m.name << " " << fixed << setprecision(4) << m.value << endl;
+    }
+    return true;
+}
+
+// 条带模式与整帧模式的产品掩码是否逐像素一致(条带光晕行数不足时出现差异)
+static bool stripedMaskMatches(ConveyorInspector& inspector, const Mat& frame) {
+    Mat full_mask, striped_mask, diff;
+    inspector.computeProductMask(frame, full_mask, false);
+    inspector.computeProductMask(frame, striped_mask, true);
+    compare(full_mask, striped_mask, diff, CMP_NE);
+    return countNonZero(diff) == 0;
+}
+
+// 逐帧比较视频的条带掩码与整帧掩码, 返回不一致的帧数
+static int compareStripedMasks(const string& video_path, int& frames_checked) {
+    frames_checked = 0;
+    VideoCapture cap(video_path);
+    if (!cap.isOpened()) {
+        return 0;
+    }
+
+    ConveyorInspector inspector;
+    Mat frame;
+    int mismatched = 0;
+    while (cap.read(frame)) {
+        if (!stripedMaskMatches(inspector, frame)) mismatched++;
+        frames_checked++;
+    }
+    return mismatched;
+}
+
+// 合成帧: 模糊后的均匀噪声取阈值, 得到紧贴条带边界、尺度与 5×5 核相当的斑块,
+// 开闭运算的影响传播到最远处, 对光晕不足敏感(测试视频中光晕减到 10 行仍一致)
+static int compareStripedMasksSynthetic(int& frames_checked) {
+    const int kFrames = 16;
+    const double kSigmas[4] = {2.0, 2.5, 3.0, 4.0};
+    const double kThresholds[3] = {0.49, 0.50, 0.51};
+
+    ConveyorInspector inspector;
+    Mat noise, blobs, frame;
+    int mismatched = 0;
+    for (int i = 0; i < kFrames; i++) {
+        RNG rng(1000 + i);
+        noise.create(720, 1216, CV_32FC1);
+        rng.fill(noise, RNG::UNIFORM, 0.0, 1.0);
+        GaussianBlur(noise, noise, Size(0, 0), kSigmas[i % 4]);
+        compare(noise, kThresholds[i % 3], blobs, CMP_LT);
+        cvtColor(blobs, frame, COLOR_GRAY2BGR);
+        if (!stripedMaskMatches(inspector, frame)) mismatched++;
+    }
+    frames_checked = kFrames;
+    return mismatched;
+}
+
+static string baseName(const string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return slash == string::npos ? path : path.substr(slash + 1);
+}
+
+static void printUsage(const char* program_name) {
+    cout << "回归基准测试" << endl;
+    cout << endl;
+    cout << "用法: " << program_name << " [选项]" << endl;
+    cout << endl;
+    cout << "选项:" << endl;
+    cout << "  --baseline <路径>    性能基线文件(默认 <构建目录>/benchmark/baseline_timings.txt)" << endl;
+    cout << "  --update-baseline    用本次结果覆盖性能基线" << endl;
+    cout << "  --threshold <比例>   吞吐量低于基线该比例即判定回归(默认 0.20)" << endl;
+    cout << "  --repeat <次数>      每张公式图片重复识别次数, 取中位数(默认 5)" << endl;
+    cout << "  --skip-video         跳过流水线视频部分" << endl;
+    cout << endl;
+}
+
+int main(int argc, char** argv) {
+    string source_dir = BENCH_SOURCE_DIR;
+    // 基线与机器相关, 默认写在构建目录, 不污染源码树
+    string baseline_path = string(BENCH_BINARY_DIR) + "/baseline_timings.txt";
+    string expected_path = source_dir + "/benchmark/expected_results.txt";
+    bool update_baseline = false;
+    double threshold = 0.20;
+    int repeat = 5;
+    bool skip_video = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--baseline" && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (arg == "--update-baseline") {
+            update_baseline = true;
+        } else if (arg == "--threshold" && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            repeat = max(1, atoi(argv[++i]));
+        } else if (arg == "--skip-video") {
+            skip_video = true;
+        } else {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+
+    ExpectedResults expected;
+    if (!loadExpected(expected_path, expected)) {
+        cerr << "错误: 无法读取期望输出 " << expected_path << endl;
+        return -1;
+    }
+
+    vector<Metric> metrics;
+    int failures = 0;
+    int pending_failures = 0;
+    NullBuffer null_buffer;
+    streambuf* cout_buffer = cout.rdbuf();
+
+    // ------------------------------------------------------------------
+    // Task 1: 流水线视频
+    // ------------------------------------------------------------------
+    if (!skip_video) {
+        cout << "========== Task 1: 流水线产品质量检测 ==========" << endl;
+        FrameTracer& tracer = FrameTracer::instance();
+        tracer.enable(1 << 20);
+
+        for (const auto& entry : expected.videos) {
+            string video_path = source_dir + "/task1_conveyor_inspection/video/" + entry.first;
+            tracer.clear();
+
+            ConveyorInspector inspector;
+            TickMeter tm;
+            cout.rdbuf(&null_buffer);
+            tm.start();
+            inspector.processVideo(video_path, false);
+            tm.stop();
+            cout.rdbuf(cout_buffer);
+
+            int frames = inspector.getFrameCount();
+            if (frames == 0) {
+                cout << "✗ " << entry.first << ": 无法读取视频" << endl;
+                failures++;
+                continue;
+            }
+
+            bool ok = inspector.getQualifiedCount() == entry.second.first &&
+                      inspector.getDefectiveCount() == entry.second.second;
+            if (!ok) failures++;
+
+            double fps = frames / tm.getTimeSec();
+            cout << (ok ? "✓ " : "✗ ") << entry.first
+                 << ": 合格品 " << inspector.getQualifiedCount() << "/" << entry.second.first
+                 << ", 次品 " << inspector.getDefectiveCount() << "/" << entry.second.second
+                 << ", " << fixed << setprecision(1) << fps << " fps" << endl;
+
+            string prefix = "conveyor/" + entry.first + "/";
+            metrics.push_back(Metric{prefix + "fps", fps, true});
+
+            vector<double> total_ms;
+            vector<uint64_t> counts;
+            tracer.summarize(total_ms, counts);
+            for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+                if (counts[s] == 0) continue;
+                string stage = FrameTracer::stageName(static_cast<TraceStage>(s));
+                replace(stage.begin(), stage.end(), ' ', '_');
+                metrics.push_back(Metric{prefix + stage + "_ms", total_ms[s] / frames, false});
+            }
+
+            // 条带并行掩码(--striped)必须与整帧掩码逐像素一致
+            int mask_frames = 0;
+            int mask_mismatched = compareStripedMasks(video_path, mask_frames);
+            bool mask_ok = mask_frames == frames && mask_mismatched == 0;
+            if (!mask_ok) failures++;
+            cout << (mask_ok ? "✓ " : "✗ ") << entry.first << ": 条带掩码与整帧掩码一致 "
+                 << (mask_frames - mask_mismatched) << "/" << mask_frames << " 帧" << endl;
+        }
+
+        int synthetic_frames = 0;
+        int synthetic_mismatched = compareStripedMasksSynthetic(synthetic_frames);
+        if (synthetic_mismatched > 0) failures++;
+        cout << (synthetic_mismatched == 0 ? "✓ " : "✗ ") << "合成斑块帧: 条带掩码与整帧掩码一致 "
+             << (synthetic_frames - synthetic_mismatched) << "/" << synthetic_frames << " 帧" << endl;
+        cout << endl;
+    }
+
+    // ------------------------------------------------------------------
+    // Task 2: 公式识别
+    // ------------------------------------------------------------------
+    cout << "========== Task 2: 公式识别 ==========" << endl;
+    vector<String> image_paths;
+    glob(source_dir + "/task2_formula_recognition/formula_images/*.png", image_paths);
+    sort(image_paths.begin(), image_paths.end());
+
+    FormulaRecognizer recognizer;
+    double total_recognize_sec = 0.0;
+    int image_count = 0;
+    map<string, bool> seen_images;
+
+    for (const auto& path : image_paths) {
+        string name = baseName(path);
+        if (name.find("_result.") != string::npos) continue;
+        seen_images[name] = true;
+
+        TickMeter decode_tm;
+        decode_tm.start();
+        Mat image = imread(path);
+        decode_tm.stop();
+        if (image.empty()) {
+            cout << "✗ " << name << ": 无法读取图像" << endl;
+            failures++;
+            continue;
+        }
+
+        vector<FormulaResult> results;
+        vector<double> times_ms;
+        cout.rdbuf(&null_buffer);
+        for (int r = 0; r < repeat; r++) {
+            TickMeter tm;
+            tm.start();
+            results = recognizer.recognizeMultipleFormulas(image);
+            tm.stop();
+            times_ms.push_back(tm.getTimeMilli());
+        }
+        cout.rdbuf(cout_buffer);
+
+        sort(times_ms.begin(), times_ms.end());
+        double median_ms = times_ms[times_ms.size() / 2];
+        total_recognize_sec += median_ms / 1000.0;
+        image_count++;
+
+        vector<string> expressions, values;
+        for (const auto& result : results) {
+            expressions.push_back(result.expression);
+            values.push_back(formatValue(result.result));
+        }
+        string recognized = joinList(expressions);
+        if (!values.empty()) recognized += " " + joinList(values);
+
+        string status = "  ";
+        auto it = expected.formulas.find(name);
+        if (it != expected.formulas.end()) {
+            const ExpectedFormula& want = it->second;
+            bool ok = (expressions == want.expressions);
+            for (size_t i = 0; ok && i < want.values.size(); i++) {
+                ok = valueMatches(results[i].result, want.values[i]);
+            }
+            if (!ok) {
+                if (want.pending) pending_failures++;
+                else failures++;
+                recognized += "  (期望 " + joinList(want.expressions);
+                if (!want.values.empty()) recognized += " " + joinList(want.values);
+                recognized += ")";
+            } else if (want.pending) {
+                recognized += "  (已通过, 可在期望输出中改为 formula)";
+            }
+            status = ok ? "✓ " : (want.pending ? "○ " : "✗ ");
+        }
+
+        cout << status << left << setw(24) << name << right
+             << fixed << setprecision(2) << setw(8) << median_ms << " ms  "
+             << recognized << endl;
+
+        string prefix = "formula/" + name + "/";
+        metrics.push_back(Metric{prefix + "decode_ms", decode_tm.getTimeMilli(), false});
+        metrics.push_back(Metric{prefix + "recognize_ms", median_ms, false});
+    }
+
+    // 期望输出中列出但目录中不存在的图片
+    for (const auto& entry : expected.formulas) {
+        if (!seen_images.count(entry.first)) {
+            cout << "✗ " << entry.first << ": 图片不存在" << endl;
+            failures++;
+        }
+    }
+
+    if (image_count > 0) {
+        double images_per_sec = image_count / total_recognize_sec;
+        metrics.push_back(Metric{"formula/images_per_sec", images_per_sec, true});
+        cout << "吞吐量: " << fixed << setprecision(1) << images_per_sec << " images/s" << endl;
+    }
+    cout << endl;
+
+    // ------------------------------------------------------------------
+    // 性能基线比较
+    // ------------------------------------------------------------------
+    cout << "========== 性能基线 ==========" << endl;
+    map<string, double> baseline = loadBaseline(baseline_path);
+    int regressions = 0;
+
+    if (baseline.empty() || update_baseline) {
+        if (saveBaseline(baseline_path, metrics)) {
+            cout << (baseline.empty() ? "无已有基线, 本次未比较, " : "") << "已记录性能基线: "
+                 << baseline_path << endl;
+        } else {
+            cerr << "错误: 无法写入性能基线 " << baseline_path << endl;
+            failures++;
+        }
+    } else {
+        for (const auto& m : metrics) {
+            auto it = baseline.find(m.name);
+            if (it == baseline.end() || it->second <= 0) continue;
+
+            double ratio = m.value / it->second;
+            bool regressed = m.throughput ? (ratio < 1.0 - threshold) : false;
+            if (regressed) regressions++;
+
+            if (m.throughput || ratio > 1.0 + threshold) {
+                cout << (regressed ? "✗ " : "  ") << left << setw(48) << m.name << right
+                     << fixed << setprecision(2) << setw(10) << it->second << " -> "
+                     << setw(10) << m.value << "  (" << showpos << setprecision(1)
+                     << (ratio - 1.0) * 100.0 << noshowpos << "%)" << endl;
+            }
+        }
+        cout << "回归阈值: 吞吐量下降超过 " << fixed << setprecision(0)
+             << threshold * 100.0 << "%" << endl;
+    }
+    cout << endl;
+
+    cout << "============================================================" << endl;
+    cout << "结果校验失败: " << failures << ", 性能回归: " << regressions
+         << ", 未支持(不计入失败): " << pending_failures << endl;
+    cout << "============================================================" << endl;
+
+    return (failures == 0 && regressions == 0) ? 0 : 1;
+}
@@ -4,12 +4,80 @@
  */
 
 #include "conveyor_inspector.h"
+#include "frame_tracer.h"
+#include "inspection_log.h"
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <algorithm>
 #include <cmath>
 
+const char* productTypeName(ProductType type) {
+    return type == ProductType::Qualified ? "qualified" : "defective";
+}
+
+// ============================================================================
+// TrackTable 实现
+// ============================================================================
+
+void TrackTable::clear() {
+    id.clear();
+    centroid.clear();
+    prev_centroid.clear();
+    initial_pos.clear();
+    frames_tracked.clear();
+    frames_lost.clear();
+    counted.clear();
+    det_index.clear();
+    type.clear();
+    angle.clear();
+    scale.clear();
+}
+
+void TrackTable::push_back(const TrackedProduct& track) {
+    id.push_back(track.id);
+    centroid.push_back(track.centroid);
+    prev_centroid.push_back(track.prev_centroid);
+    initial_pos.push_back(track.initial_pos);
+    frames_tracked.push_back(track.frames_tracked);
+    frames_lost.push_back(track.frames_lost);
+    counted.push_back(track.counted ? 1 : 0);
+    det_index.push_back(track.det_index);
+    type.push_back(track.type);
+    angle.push_back(track.angle);
+    scale.push_back(track.scale);
+}
+
+void TrackTable::appendRow(const TrackTable& src, size_t i) {
+    id.push_back(src.id[i]);
+    centroid.push_back(src.centroid[i]);
+    prev_centroid.push_back(src.prev_centroid[i]);
+    initial_pos.push_back(src.initial_pos[i]);
+    frames_tracked.push_back(src.frames_tracked[i]);
+    frames_lost.push_back(src.frames_lost[i]);
+    counted.push_back(src.counted[i]);
+    det_index.push_back(src.det_index[i]);
+    type.push_back(src.type[i]);
+    angle.push_back(src.angle[i]);
+    scale.push_back(src.scale[i]);
+}
+
+TrackedProduct TrackTable::row(size_t i) const {
+    TrackedProduct track;
+    track.id = id[i];
+    track.centroid = centroid[i];
+    track.prev_centroid = prev_centroid[i];
+    track.initial_pos = initial_pos[i];
+    track.frames_tracked = frames_tracked[i];
+    track.frames_lost = frames_lost[i];
+    track.counted = counted[i] != 0;
+    track.det_index = det_index[i];
+    track.type = type[i];
+    track.angle = angle[i];
+    track.scale = scale[i];
+    return track;
+}
+
 // ============================================================================
 // ProductTracker 类实现
 // ============================================================================
@@ -17,66 +85,194 @@
 ProductTracker::ProductTracker(float dist_thresh)
     : next_id(0), distance_threshold(dist_thresh) {}
 
-vector<TrackedProduct>& ProductTracker::update(const vector<Point2f>& centroids) {
-    vector<TrackedProduct> new_tracked;
+TrackTable& ProductTracker::update(const vector<Detection>& detections) {
+    next.clear();
+    matched.assign(tracks.size(), 0);
 
-    for (const auto& centroid : centroids) {
-        bool matched = false;
+    for (size_t i = 0; i < detections.size(); i++) {
+        const Detection& det = detections[i];
+        bool found = false;
 
-        for (auto& tracked : tracked_products) {
-            float dist = norm(centroid - tracked.centroid);
+        for (size_t t = 0; t < tracks.size(); t++) {
+            float dist = norm(det.centroid - tracks.centroid[t]);
 
             if (dist < distance_threshold) {
-                tracked.centroid = centroid;
-                tracked.frames_tracked++;
-                tracked.frames_lost = 0;
-                new_tracked.push_back(tracked);
-                matched = true;
+                tracks.prev_centroid[t] = tracks.centroid[t];
+                tracks.centroid[t] = det.centroid;
+                tracks.frames_tracked[t]++;
+                tracks.frames_lost[t] = 0;
+                tracks.det_index[t] = static_cast<int>(i);
+                tracks.type[t] = det.type;
+                tracks.angle[t] = det.angle;
+                tracks.scale[t] = det.scale;
+                next.appendRow(tracks, t);
+                matched[t] = 1;
+                found = true;
                 break;
             }
         }
 
-        if (!matched) {
+        if (!found) {
             TrackedProduct new_product;
             new_product.id = next_id++;
-            new_product.centroid = centroid;
-            new_product.initial_pos = centroid;  // 记录初始位置
+            new_product.centroid = det.centroid;
+            new_product.prev_centroid = det.centroid;
+            new_product.initial_pos = det.centroid;  // 记录初始位置
             new_product.frames_tracked = 1;
             new_product.frames_lost = 0;
             new_product.counted = false;
-            new_tracked.push_back(new_product);
+            new_product.det_index = static_cast<int>(i);
+            new_product.type = det.type;
+            new_product.angle = det.angle;
+            new_product.scale = det.scale;
+            next.push_back(new_product);
         }
     }
 
     // 保留未匹配但丢失帧数较少的产品
-    for (auto& tracked : tracked_products) {
-        bool found = false;
-        for (const auto& nt : new_tracked) {
-            if (nt.id == tracked.id) {
-                found = true;
-                break;
+    for (size_t t = 0; t < tracks.size(); t++) {
+        if (!matched[t]) {
+            tracks.frames_lost[t]++;
+            tracks.det_index[t] = -1;
+            tracks.prev_centroid[t] = tracks.centroid[t];  // 丢失帧不产生位移
+            if (tracks.frames_lost[t] < 10) {
+                next.appendRow(tracks, t);
             }
         }
+    }
 
-        if (!found) {
-            tracked.frames_lost++;
-            if (tracked.frames_lost < 10) {
-                new_tracked.push_back(tracked);
-            }
+    swap(tracks, next);
+    return tracks;
+}
+
+// ============================================================================
+// CountingGate 实现
+// ============================================================================
+
+// 叉积: (b - a) × (p - a), 符号表示 p 在有向线段 ab 的哪一侧
+static float crossSide(const Point2f& a, const Point2f& b, const Point2f& p) {
+    return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+}
+
+bool CountingGate::enabled() const {
+    return points.size() >= 2;
+}
+
+bool CountingGate::crossed(const Point2f& from, const Point2f& to) const {
+    if (!enabled() || from == to) {
+        return false;
+    }
+
+    if (points.size() == 2) {
+        // 计数线: 本帧位移线段与计数线段相交(半开区间,恰好落在线上只计一次)
+        const Point2f& a = points[0];
+        const Point2f& b = points[1];
+        bool from_side = crossSide(a, b, from) < 0;
+        bool to_side = crossSide(a, b, to) < 0;
+        if (from_side == to_side) {
+            return false;
         }
+        bool a_side = crossSide(from, to, a) < 0;
+        bool b_side = crossSide(from, to, b) < 0;
+        return a_side != b_side;
     }
 
-    tracked_products = new_tracked;
-    return tracked_products;
+    // 计数多边形: 上一帧在门外, 本帧在门内(含边界)
+    return pointPolygonTest(points, from, false) < 0 &&
+           pointPolygonTest(points, to, false) >= 0;
 }
 
 // ============================================================================
 // ConveyorInspector 类实现
 // ============================================================================
 
+// ============================================================================
+// 产品掩码: 背景分离 + 形态学去噪
+// ============================================================================
+
+// 条带模式每个条带的目标行数(含光晕后工作集约为 L2 缓存大小)
+static const int kStripeRows = 128;
+
+// 条带上下光晕行数: 开运算2次(腐蚀×2+膨胀×2) + 闭运算(膨胀+腐蚀)
+// 共6次 5×5 矩形核运算, 每次影响半径2行, 合计12行
+static const int kMorphHalo = 12;
+
+// 掩码流水线: HSV 转换 → 背景分离 → 开运算×2 → 闭运算
+// 整帧模式与条带模式共用, 保证两者逐像素一致
+static void buildProductMask(const Mat& frame, Mat& mask) {
+    {
+        TraceScope trace(TRACE_MASK);
+        Mat hsv;
+        cvtColor(frame, hsv, COLOR_BGR2HSV);
+
+        Scalar lower_white(0, 0, 200);
+        Scalar upper_white(179, 30, 255);
+        inRange(hsv, lower_white, upper_white, mask);
+
+        bitwise_not(mask, mask);
+    }
+
+    // 形态学操作:开运算去噪 + 闭运算填充空洞
+    TraceScope trace(TRACE_MORPHOLOGY);
+    Mat kernel = getStructuringElement(MORPH_RECT, Size(5, 5));
+    morphologyEx(mask, mask, MORPH_OPEN, kernel, Point(-1,-1), 2);
+    morphologyEx(mask, mask, MORPH_CLOSE, kernel);
+}
+
 ConveyorInspector::ConveyorInspector()
     : frame_count(0), qualified_count(0), defective_count(0),
-      reference_size(0.0f), reference_initialized(false) {}
+      reference_size(0.0f), reference_initialized(false),
+      striped_morphology(false) {}
+
+ConveyorInspector::~ConveyorInspector() {}
+
+void ConveyorInspector::setCountingGate(const vector<Point2f>& points) {
+    gate.points = points;
+}
+
+void ConveyorInspector::setStripedMorphology(bool enabled) {
+    striped_morphology = enabled;
+}
+
+bool ConveyorInspector::setRecordPath(const string& path) {
+    recorder.reset(new InspectionLogWriter());
+    if (!recorder->open(path)) {
+        recorder.reset();
+        return false;
+    }
+    return true;
+}
+
+// 条带模式: 帧按水平条带切分, 每个条带带光晕独立完成整条掩码流水线,
+// 工作集常驻 L2, 单路视频也能占满所有核心; 只拷回条带内部行, 结果与整帧一致
+void ConveyorInspector::computeMaskStriped(const Mat& frame, Mat& mask) {
+    mask.create(frame.rows, frame.cols, CV_8UC1);
+
+    int num_stripes = max(getNumThreads(), (frame.rows + kStripeRows - 1) / kStripeRows);
+    num_stripes = max(1, min(num_stripes, frame.rows));
+
+    parallel_for_(Range(0, num_stripes), [&](const Range& range) {
+        Mat stripe_mask;
+        for (int i = range.start; i < range.end; i++) {
+            int y0 = frame.rows * i / num_stripes;
+            int y1 = frame.rows * (i + 1) / num_stripes;
+            int a = max(0, y0 - kMorphHalo);
+            int b = min(frame.rows, y1 + kMorphHalo);
+
+            // 条带输出为独立缓冲区, 形态学不会读取条带外的像素
+            buildProductMask(frame.rowRange(a, b), stripe_mask);
+            stripe_mask.rowRange(y0 - a, y1 - a).copyTo(mask.rowRange(y0, y1));
+        }
+    });
+}
+
+void ConveyorInspector::computeProductMask(const Mat& frame, Mat& mask, bool striped) {
+    if (striped) {
+        computeMaskStriped(frame, mask);
+    } else {
+        buildProductMask(frame, mask);
+    }
+}
 
 // 计算矩形旋转角度(正置=长边水平为0°)
 float ConveyorInspector::calculateRectangleAngle(const RotatedRect& rect) {
@@ -98,21 +294,11 @@ float ConveyorInspector::calculateRectangleAngle(const RotatedRect& rect) {
 vector<Detection> ConveyorInspector::detectProducts(const Mat& frame) {
     vector<Detection> detections;
 
-    Mat hsv, mask;
-    cvtColor(frame, hsv, COLOR_BGR2HSV);
-
-    Scalar lower_white(0, 0, 200);
-    Scalar upper_white(179, 30, 255);
-    inRange(hsv, lower_white, upper_white, mask);
-
-    bitwise_not(mask, mask);
-
-    // 形态学操作:开运算去噪 + 闭运算填充空洞
-    Mat kernel = getStructuringElement(MORPH_RECT, Size(5, 5));
-    morphologyEx(mask, mask, MORPH_OPEN, kernel, Point(-1,-1), 2);
-    morphologyEx(mask, mask, MORPH_CLOSE, kernel);
+    Mat mask;
+    computeProductMask(frame, mask, striped_morphology);
 
     // 查找轮廓
+    TraceScope trace(TRACE_CONTOURS);
     vector<vector<Point>> contours;
     findContours(mask, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
 
@@ -122,8 +308,6 @@ vector<Detection> ConveyorInspector::detectProducts(const Mat& frame) {
 
         // 获取最小外接矩形
         RotatedRect rect = minAreaRect(contour);
-        Point2f vertices[4];
-        rect.points(vertices);
 
         vector<Point> approx;
         approxPolyDP(contour, approx, arcLength(contour, true) * 0.03, true);
@@ -138,10 +322,10 @@ vector<Detection> ConveyorInspector::detectProducts(const Mat& frame) {
         Detection det;
         det.centroid = rect.center;
         det.rect = rect;
-        det.box = vector<Point>(vertices, vertices + 4);
+        rect.points(det.box.data());
 
         if (is_rectangular) {
-            det.type = "qualified";
+            det.type = ProductType::Qualified;
             det.angle = calculateRectangleAngle(rect);
 
             // 初始化缩放基准（使用首个合格品的长边尺寸）
@@ -153,7 +337,7 @@ vector<Detection> ConveyorInspector::detectProducts(const Mat& frame) {
             }
             det.scale = current_size / reference_size;
         } else {
-            det.type = "defective";
+            det.type = ProductType::Defective;
             det.angle = rect.angle;
             while (det.angle < 0) det.angle += 360.0f;
             while (det.angle >= 360.0f) det.angle -= 360.0f;
@@ -168,21 +352,29 @@ vector<Detection> ConveyorInspector::detectProducts(const Mat& frame) {
     return detections;
 }
 
-void ConveyorInspector::updateCounts(const vector<Detection>& detections,
-                                     vector<TrackedProduct>& tracked) {
-    for (auto& track : tracked) {
-        if (track.counted) {
+void ConveyorInspector::updateCounts(TrackTable& tracks) {
+    for (size_t i = 0; i < tracks.size(); i++) {
+        // 只处理本帧有关联检测的未计数轨迹, 类型/角度直接取轨迹缓存
+        if (tracks.counted[i] || tracks.det_index[i] < 0) {
+            continue;
+        }
+
+        if (gate.enabled()) {
+            // 计数门模式: 质心穿越计数门的当帧立即计数
+            if (gate.crossed(tracks.prev_centroid[i], tracks.centroid[i])) {
+                countProduct(tracks, i);
+            }
             continue;
         }
 
         // 需要追踪至少10帧才计数（确保是真实产品，排除噪声）
-        if (track.frames_tracked < 10) {
+        if (tracks.frames_tracked[i] < 10) {
             continue;
         }
 
-        // 计算移动方向和距离 (当前位置 - 初始位置)
-        float dx = track.centroid.x - track.initial_pos.x;
-        float dy = track.centroid.y - track.initial_pos.y;
+        // 计算移动距离 (当前位置 - 初始位置)
+        float dx = tracks.centroid[i].x - tracks.initial_pos[i].x;
+        float dy = tracks.centroid[i].y - tracks.initial_pos[i].y;
         float total_movement = sqrt(dx*dx + dy*dy);
 
         // 必须有足够的移动距离（至少30像素，排除静止的背景）
@@ -190,61 +382,56 @@ void ConveyorInspector::updateCounts(const vector<Detection>& detections,
             continue;
         }
 
-        // 判断主要移动方向（仅用于显示）
-        string direction = "";
-        if (abs(dx) > abs(dy)) {
-            direction = (dx > 0) ? "→" : "←";
-        } else {
-            direction = (dy > 0) ? "↓" : "↑";
-        }
+        countProduct(tracks, i);
+    }
+}
 
-        // 找到对应的检测结果
-        for (const auto& det : detections) {
-            float dist = norm(det.centroid - track.centroid);
-            if (dist < 50.0f) {
-                track.counted = true;
-
-                // 记录已统计的产品信息
-                CountedProduct cp;
-                cp.id = track.id;
-                cp.type = det.type;
-                cp.angle = det.angle;
-                cp.scale = det.scale;
-                cp.frame = frame_count;
-                counted_products.push_back(cp);
-
-                if (det.type == "qualified") {
-                    qualified_count++;
-                    cout << "Frame " << frame_count << ": ✓ QUALIFIED " << direction << " - "
-                         << "ID:" << track.id << ", "
-                         << "Angle: " << fixed << setprecision(1) << det.angle << "°, "
-                         << "Scale: " << setprecision(2) << det.scale << "x | "
-                         << "Total -> Qualified: " << qualified_count
-                         << ", Defective: " << defective_count << endl;
-                } else {
-                    defective_count++;
-                    cout << "Frame " << frame_count << ": ✗ DEFECTIVE " << direction << " - "
-                         << "ID:" << track.id << ", "
-                         << "Angle: " << fixed << setprecision(1) << det.angle << "°, "
-                         << "Scale: " << setprecision(2) << det.scale << "x | "
-                         << "Total -> Qualified: " << qualified_count
-                         << ", Defective: " << defective_count << endl;
-                }
-                break;
-            }
-        }
+void ConveyorInspector::countProduct(TrackTable& tracks, size_t i) {
+    tracks.counted[i] = 1;
+    TrackedProduct track = tracks.row(i);
+
+    // 判断主要移动方向（仅用于显示）
+    float dx = track.centroid.x - track.initial_pos.x;
+    float dy = track.centroid.y - track.initial_pos.y;
+    string direction = "";
+    if (abs(dx) > abs(dy)) {
+        direction = (dx > 0) ? "→" : "←";
+    } else {
+        direction = (dy > 0) ? "↓" : "↑";
+    }
+
+    // 记录已统计的产品信息
+    CountedProduct cp;
+    cp.id = track.id;
+    cp.type = track.type;
+    cp.angle = track.angle;
+    cp.scale = track.scale;
+    cp.frame = frame_count;
+    counted_products.push_back(cp);
+
+    if (track.type == ProductType::Qualified) {
+        qualified_count++;
+        cout << "Frame " << frame_count << ": ✓ QUALIFIED " << direction << " - ";
+    } else {
+        defective_count++;
+        cout << "Frame " << frame_count << ": ✗ DEFECTIVE " << direction << " - ";
     }
+    cout << "ID:" << track.id << ", "
+         << "Angle: " << fixed << setprecision(1) << track.angle << "°, "
+         << "Scale: " << setprecision(2) << track.scale << "x | "
+         << "Total -> Qualified: " << qualified_count
+         << ", Defective: " << defective_count << endl;
 }
 
 Mat ConveyorInspector::drawDetections(const Mat& frame, const vector<Detection>& detections,
-                                       const vector<TrackedProduct>& tracked) {
+                                       const TrackTable& tracks) {
     Mat result;
     frame.copyTo(result);
 
     // 绘制每个检测到的产品
     for (const auto& det : detections) {
         // 根据类型选择颜色
-        Scalar color = (det.type == "qualified") ? Scalar(0, 255, 0) : Scalar(0, 0, 255);
+        Scalar color = (det.type == ProductType::Qualified) ? Scalar(0, 255, 0) : Scalar(0, 0, 255);
 
         // 绘制外接矩形
         for (int i = 0; i < 4; i++) {
@@ -255,8 +442,8 @@ Mat ConveyorInspector::drawDetections(const Mat& frame, const vector<Detection>&
         circle(result, det.centroid, 5, color, -1);
 
         // 显示ID、类型、角度和缩放倍数
-        for (const auto& track : tracked) {
-            float dist = norm(det.centroid - track.centroid);
+        for (size_t t = 0; t < tracks.size(); t++) {
+            float dist = norm(det.centroid - tracks.centroid[t]);
             if (dist < 50.0f) {
                 // 找到边界框的最低点（最大y坐标）
                 float max_y = det.box[0].y;
@@ -271,8 +458,8 @@ Mat ConveyorInspector::drawDetections(const Mat& frame, const vector<Detection>&
                 int text_x = static_cast<int>(det.centroid.x) - 50;
 
                 // 第1行：ID和类型
-                string label1 = format("ID:%d %s", track.id,
-                                    det.type == "qualified" ? "YES" : "NO");
+                string label1 = format("ID:%d %s", tracks.id[t],
+                                    det.type == ProductType::Qualified ? "YES" : "NO");
                 putText(result, label1, Point(text_x, base_y + 20),
                        FONT_HERSHEY_SIMPLEX, 0.6, color, 2);
 
@@ -290,6 +477,12 @@ Mat ConveyorInspector::drawDetections(const Mat& frame, const vector<Detection>&
         }
     }
 
+    // 绘制计数门(青色)
+    if (gate.enabled()) {
+        vector<Point> gate_pts(gate.points.begin(), gate.points.end());
+        polylines(result, gate_pts, gate_pts.size() > 2, Scalar(255, 255, 0), 2);
+    }
+
     rectangle(result, Point(0, 0), Point(result.cols, 70), Scalar(0, 0, 0), -1);
 
     // 第1行：统计信息
@@ -337,28 +530,55 @@ void ConveyorInspector::processVideo(const string& video_path, bool show_video)
 
     bool speed_boost = false;
 
+    FrameTracer& tracer = FrameTracer::instance();
+
     Mat frame;
-    while (cap.read(frame)) {
+    while (true) {
+        tracer.setFrame(frame_count + 1);
+        TraceScope frame_trace(TRACE_FRAME);
+
+        {
+            TraceScope trace(TRACE_DECODE);
+            if (!cap.read(frame)) {
+                // 视频结束: 最后一次失败的读取不算一帧
+                trace.cancel();
+                frame_trace.cancel();
+                break;
+            }
+        }
         frame_count++;
 
         // 检测产品
         vector<Detection> detections = detectProducts(frame);
 
-        // 提取质心用于追踪
-        vector<Point2f> centroids;
-        for (const auto& det : detections) {
-            centroids.push_back(det.centroid);
+        // 更新追踪器(轨迹缓存关联检测的类型和角度)
+        TrackTable* tracked_ptr;
+        {
+            TraceScope trace(TRACE_TRACKER);
+            tracked_ptr = &tracker.update(detections);
         }
-
-        // 更新追踪器
-        vector<TrackedProduct>& tracked = tracker.update(centroids);
+        TrackTable& tracked = *tracked_ptr;
 
         // 更新计数
-        updateCounts(detections, tracked);
+        size_t counted_before = counted_products.size();
+        {
+            TraceScope trace(TRACE_COUNTING);
+            updateCounts(tracked);
+        }
+
+        if (recorder) {
+            recorder->writeFrame(frame_count, detections, tracked,
+                                 counted_products.data() + counted_before,
+                                 counted_products.size() - counted_before);
+        }
 
         // 显示或保存视频
         if (gui_available || use_video_output) {
-            Mat result = drawDetections(frame, detections, tracked);
+            Mat result;
+            {
+                TraceScope trace(TRACE_DRAW);
+                result = drawDetections(frame, detections, tracked);
+            }
 
             if (speed_boost && gui_available) {
                 string speed_hint = ">> FAST FORWARD (Press Right Arrow to Normal) <<";
@@ -368,10 +588,14 @@ void ConveyorInspector::processVideo(const string& video_path, bool show_video)
 
             if (gui_available && !use_video_output) {
                 try {
-                    imshow("Product Inspection", result);
+                    int key;
+                    {
+                        TraceScope trace(TRACE_DISPLAY_WAIT);
+                        imshow("Product Inspection", result);
 
-                    int delay = speed_boost ? 5 : 30;
-                    int key = waitKeyEx(delay);
+                        int delay = speed_boost ? 5 : 30;
+                        key = waitKeyEx(delay);
+                    }
 
                     if (key == 27 || key == 'q') {  // ESC或q键退出
                         cout << "\n用户中断播放" << endl;
@@ -426,6 +650,7 @@ void ConveyorInspector::processVideo(const string& video_path, bool show_video)
             }
 
             if (use_video_output && video_writer.isOpened()) {
+                TraceScope trace(TRACE_ENCODE);
                 video_writer.write(result);
             }
         }
@@ -442,6 +667,10 @@ end_video:  // goto标签，用于从暂停状态退出
         cout << "结果视频已保存" << endl;
     }
 
+    if (recorder && !recorder->close()) {
+        cerr << "错误: 检测记录写入失败" << endl;
+    }
+
     cout << endl;
     cout << "视频处理完成！" << endl;
     cout << endl;
@@ -492,7 +721,7 @@ void ConveyorInspector::printStatistics(const string& video_path) {
         scale_str << fixed << setprecision(2) << prod.scale << "x";
 
         cout << left << setw(6) << prod.id
-             << setw(12) << (prod.type == "qualified" ? "✓ 合格品" : "✗ 次品")
+             << setw(12) << (prod.type == ProductType::Qualified ? "✓ 合格品" : "✗ 次品")
              << setw(15) << angle_str.str()
              << setw(15) << scale_str.str()
              << setw(10) << prod.frame << endl;
@@ -7,51 +7,104 @@
 #define CONVEYOR_INSPECTOR_H
 
 #include <opencv2/opencv.hpp>
+#include <array>
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <string>
 
 using namespace cv;
 using namespace std;
 
-// 产品追踪结构体
+class InspectionLogWriter;
+
+// 产品类型
+enum class ProductType : uint8_t {
+    Qualified = 0,         // 合格品(矩形)
+    Defective = 1          // 次品
+};
+
+// 类型名 "qualified" / "defective"
+const char* productTypeName(ProductType type);
+
+// 检测结果结构体(定长, 无堆分配)
+struct Detection {
+    ProductType type;      // 合格 / 次品
+    Point2f centroid;      // 质心坐标
+    float angle;           // 旋转角度
+    float scale;           // 缩放倍数
+    RotatedRect rect;      // 最小外接矩形
+    array<Point2f, 4> box; // 边界框顶点
+};
+
+// 单条产品轨迹(记录形式, 用于序列化与跨线程传递; 追踪器内部按列存储, 见 TrackTable)
 struct TrackedProduct {
     int id;                // 产品唯一ID
     Point2f centroid;      // 质心坐标
+    Point2f prev_centroid; // 上一帧质心(用于判断是否穿越计数门)
     Point2f initial_pos;   // 初始位置(用于判断移动方向)
     int frames_tracked;    // 已追踪帧数
     int frames_lost;       // 丢失帧数计数
     bool counted;          // 是否已统计
+    int det_index;         // 本帧关联的检测序号(-1表示本帧丢失)
+    ProductType type;      // 最近一次关联检测的类型(缓存)
+    float angle;           // 最近一次关联检测的旋转角度(缓存)
+    float scale;           // 最近一次关联检测的缩放倍数(缓存)
 };
 
-// 检测结果结构体
-struct Detection {
-    string type;           // "qualified"(合格) 或 "defective"(次品)
-    Point2f centroid;      // 质心坐标
-    float angle;           // 旋转角度
-    float scale;           // 缩放倍数
-    RotatedRect rect;      // 最小外接矩形
-    vector<Point> box;     // 边界框顶点
+// 虚拟计数门
+// 2个顶点为计数线: 质心轨迹与线段相交即计数
+// 3个及以上顶点为计数多边形: 质心从门外进入门内即计数
+struct CountingGate {
+    vector<Point2f> points;
+
+    bool enabled() const;
+    bool crossed(const Point2f& from, const Point2f& to) const;
 };
 
 // 已统计产品记录
 struct CountedProduct {
     int id;                // 产品ID
-    string type;           // 类型
+    ProductType type;      // 类型
     float angle;           // 旋转角度
     float scale;           // 缩放倍数
     int frame;             // 统计时的帧号
 };
 
+// 轨迹表(结构数组布局): 每个字段一个连续数组, 下标 i 的各字段属于同一条轨迹
+// 匹配时只扫描 centroid 列, 计数时只扫描 counted/det_index 列
+struct TrackTable {
+    vector<int> id;
+    vector<Point2f> centroid;
+    vector<Point2f> prev_centroid;
+    vector<Point2f> initial_pos;
+    vector<int> frames_tracked;
+    vector<int> frames_lost;
+    vector<uint8_t> counted;
+    vector<int> det_index;
+    vector<ProductType> type;
+    vector<float> angle;
+    vector<float> scale;
+
+    size_t size() const { return id.size(); }
+    void clear();
+    void push_back(const TrackedProduct& track);
+    void appendRow(const TrackTable& src, size_t i);
+    TrackedProduct row(size_t i) const;
+};
+
 // 产品追踪器类
 class ProductTracker {
 private:
-    vector<TrackedProduct> tracked_products;
+    TrackTable tracks;
+    TrackTable next;               // 双缓冲, 每帧交换, 稳定状态下不再分配
+    vector<uint8_t> matched;       // 本帧被检测关联过的旧轨迹
     int next_id;
     float distance_threshold;
 
 public:
     ProductTracker(float dist_thresh = 80.0f);
-    vector<TrackedProduct>& update(const vector<Point2f>& centroids);
+    TrackTable& update(const vector<Detection>& detections);
 };
 
 // 流水线检测器类
@@ -64,19 +117,33 @@ private:
     float reference_size;  // 缩放基准尺寸（使用首个合格品）
     bool reference_initialized;  // 是否已初始化基准
     vector<CountedProduct> counted_products;  // 已统计产品列表
+    CountingGate gate;     // 虚拟计数门(未设置时使用轨迹长度规则计数)
+    bool striped_morphology;  // 是否按水平条带并行执行掩码+形态学
+    unique_ptr<InspectionLogWriter> recorder;  // 二进制检测记录(未设置时为空)
 
     // 私有方法
     vector<Detection> detectProducts(const Mat& frame);
-    void updateCounts(const vector<Detection>& detections,
-                     vector<TrackedProduct>& tracked);
+    void computeMaskStriped(const Mat& frame, Mat& mask);
+    void updateCounts(TrackTable& tracks);
+    void countProduct(TrackTable& tracks, size_t i);
     Mat drawDetections(const Mat& frame, const vector<Detection>& detections,
-                      const vector<TrackedProduct>& tracked);
+                      const TrackTable& tracks);
     float calculateRectangleAngle(const RotatedRect& rect);  // 计算矩形正置角度
 
 public:
     ConveyorInspector();
+    ~ConveyorInspector();
+    void setCountingGate(const vector<Point2f>& points);
+    void setStripedMorphology(bool enabled);
+    bool setRecordPath(const string& path);  // 逐帧写入检测、轨迹与计数事件的二进制记录
+    // 产品掩码: striped 为 true 时按水平条带并行计算, 结果应与整帧逐像素一致(回归基准据此校验)
+    void computeProductMask(const Mat& frame, Mat& mask, bool striped);
     void processVideo(const string& video_path, bool show_video = false);
     void printStatistics(const string& video_path);
+
+    int getFrameCount() const { return frame_count; }
+    int getQualifiedCount() const { return qualified_count; }
+    int getDefectiveCount() const { return defective_count; }
 };
 
 #endif // CONVEYOR_INSPECTOR_H
@@ -0,0 +1,157 @@
+/**
+ * 流水线产品质量检测系统 - 帧级追踪实现文件
+ * 每线程环形缓冲区记录阶段耗时, 结束时导出 Chrome trace-event JSON
+ */
+
+#include "frame_tracer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+static const char* kStageNames[TRACE_STAGE_COUNT] = {
+    "frame", "decode", "mask", "morphology", "contours",
+    "tracker", "counting", "draw", "encode", "display wait"
+};
+
+// ============================================================================
+// FrameTracer 类实现
+// ============================================================================
+
+FrameTracer::ThreadBuffer::ThreadBuffer(int id, size_t cap)
+    : tid(id), chunks((cap + kChunkEvents - 1) / kChunkEvents), written(0) {}
+
+FrameTracer::FrameTracer()
+    : enabled_(false), current_frame(0), capacity(0), origin_ns(0),
+      stall_ns(0), stall_dumps(0) {}
+
+FrameTracer& FrameTracer::instance() {
+    static FrameTracer tracer;
+    return tracer;
+}
+
+int64_t FrameTracer::nowNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void FrameTracer::enable(size_t events_per_thread) {
+    lock_guard<mutex> lock(buffers_mutex);
+    if (enabled()) {
+        return;
+    }
+    capacity = max<size_t>(events_per_thread, 1);
+    origin_ns = nowNs();
+    enabled_.store(true, memory_order_release);
+}
+
+FrameTracer::ThreadBuffer* FrameTracer::threadBuffer() {
+    static thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer == nullptr) {
+        lock_guard<mutex> lock(buffers_mutex);
+        buffers.push_back(unique_ptr<ThreadBuffer>(
+            new ThreadBuffer(static_cast<int>(buffers.size()) + 1, capacity)));
+        buffer = buffers.back().get();
+    }
+    return buffer;
+}
+
+void FrameTracer::record(TraceStage stage, int64_t start_ns, int64_t end_ns) {
+    ThreadBuffer* buffer = threadBuffer();
+    uint64_t n = buffer->written.load(memory_order_relaxed);
+
+    size_t pos = n % capacity;
+    unique_ptr<TraceEvent[]>& chunk = buffer->chunks[pos / kChunkEvents];
+    if (!chunk) {
+        chunk.reset(new TraceEvent[kChunkEvents]);
+    }
+
+    TraceEvent& ev = buffer->at(pos);
+    ev.start_ns = start_ns - origin_ns;
+    int64_t dur = end_ns - start_ns;
+    ev.dur_ns = static_cast<uint32_t>(min<int64_t>(max<int64_t>(dur, 0), UINT32_MAX));
+    ev.frame = current_frame.load(memory_order_relaxed);
+    ev.stage = static_cast<uint8_t>(stage);
+
+    buffer->written.store(n + 1, memory_order_release);
+
+    if (stage == TRACE_FRAME && stall_ns > 0 && dur >= stall_ns) {
+        dumpStall(ev.frame, dur);
+    }
+}
+
+void FrameTracer::setStallDump(double threshold_ms, const string& path_prefix) {
+    stall_ns = static_cast<int64_t>(threshold_ms * 1e6);
+    stall_prefix = path_prefix;
+}
+
+void FrameTracer::dumpStall(int frame, int64_t dur_ns) {
+    if (stall_dumps >= kMaxStallDumps) {
+        return;
+    }
+    stall_dumps++;
+
+    string path = stall_prefix + ".stall-" + to_string(frame) + ".json";
+    bool ok = writeChromeTrace(path);
+    fprintf(stderr, "追踪: 第 %d 帧耗时 %.1f ms, %s %s%s\n", frame, dur_ns / 1e6,
+            ok ? "已导出最近事件到" : "无法写入", path.c_str(),
+            stall_dumps == kMaxStallDumps ? " (已达导出上限, 之后的卡顿不再导出)" : "");
+}
+
+bool FrameTracer::writeChromeTrace(const string& path) {
+    FILE* fp = fopen(path.c_str(), "w");
+    if (fp == nullptr) {
+        return false;
+    }
+
+    lock_guard<mutex> lock(buffers_mutex);
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"conveyor_inspection\"}}");
+
+    for (const auto& buffer : buffers) {
+        fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                    "\"args\":{\"name\":\"%s\"}}",
+                buffer->tid, buffer->tid == 1 ? "main" : "worker");
+
+        // 环形缓冲区只保留最近 capacity 个事件
+        uint64_t total = buffer->written.load(memory_order_acquire);
+        uint64_t first = total > capacity ? total - capacity : 0;
+        for (uint64_t n = first; n < total; n++) {
+            const TraceEvent& ev = buffer->at(n % capacity);
+            fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"conveyor\",\"ph\":\"X\","
+                        "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,"
+                        "\"args\":{\"frame\":%d}}",
+                    kStageNames[ev.stage], ev.start_ns / 1000.0, ev.dur_ns / 1000.0,
+                    buffer->tid, ev.frame);
+        }
+    }
+
+    fprintf(fp, "\n]}\n");
+    return fclose(fp) == 0;
+}
+
+void FrameTracer::summarize(vector<double>& total_ms, vector<uint64_t>& counts) {
+    total_ms.assign(TRACE_STAGE_COUNT, 0.0);
+    counts.assign(TRACE_STAGE_COUNT, 0);
+
+    lock_guard<mutex> lock(buffers_mutex);
+    for (const auto& buffer : buffers) {
+        uint64_t total = buffer->written.load(memory_order_acquire);
+        uint64_t first = total > capacity ? total - capacity : 0;
+        for (uint64_t n = first; n < total; n++) {
+            const TraceEvent& ev = buffer->at(n % capacity);
+            total_ms[ev.stage] += ev.dur_ns / 1e6;
+            counts[ev.stage]++;
+        }
+    }
+}
+
+void FrameTracer::clear() {
+    lock_guard<mutex> lock(buffers_mutex);
+    for (const auto& buffer : buffers) {
+        buffer->written.store(0, memory_order_release);
+    }
+}
+
+const char* FrameTracer::stageName(TraceStage stage) {
+    return kStageNames[stage];
+}
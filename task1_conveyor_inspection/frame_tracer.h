@@ -0,0 +1,121 @@
+/**
+ * 流水线产品质量检测系统 - 帧级追踪头文件
+ * 记录每帧各阶段的起止时间, 导出 Chrome trace-event JSON (可在 Perfetto 中查看)
+ */
+
+#ifndef FRAME_TRACER_H
+#define FRAME_TRACER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// 追踪阶段
+enum TraceStage {
+    TRACE_FRAME = 0,       // 整帧
+    TRACE_DECODE,          // 视频解码
+    TRACE_MASK,            // HSV 转换 + 背景分离
+    TRACE_MORPHOLOGY,      // 形态学去噪
+    TRACE_CONTOURS,        // 轮廓提取与分类
+    TRACE_TRACKER,         // 质心追踪
+    TRACE_COUNTING,        // 计数
+    TRACE_DRAW,            // 结果绘制
+    TRACE_ENCODE,          // 结果视频编码
+    TRACE_DISPLAY_WAIT,    // 窗口显示与按键等待
+    TRACE_STAGE_COUNT
+};
+
+// 单个追踪事件(24字节, 无堆分配)
+struct TraceEvent {
+    int64_t start_ns;      // 相对追踪器启动时刻的开始时间
+    uint32_t dur_ns;       // 持续时间(超过约4.29秒时截断)
+    int32_t frame;         // 帧号
+    uint8_t stage;         // TraceStage
+};
+
+// 帧级追踪器
+// 每个线程写入自己的环形缓冲区, 记录路径无锁; 缓冲区写满后覆盖最早的事件
+// 缓冲区按 kChunkEvents 分块, 写到某块时才分配, 短时运行或只偶尔记录的工作线程只占用少量内存
+class FrameTracer {
+private:
+    static const size_t kChunkEvents = 4096;  // 每块约 96KB
+
+    struct ThreadBuffer {
+        int tid;
+        vector<unique_ptr<TraceEvent[]>> chunks;  // 容量按块划分, 未写到的块为空
+        atomic<uint64_t> written;  // 累计写入数, 取模得到写入位置
+
+        ThreadBuffer(int id, size_t capacity);
+        TraceEvent& at(size_t pos) { return chunks[pos / kChunkEvents][pos % kChunkEvents]; }
+    };
+
+    atomic<bool> enabled_;
+    atomic<int> current_frame;
+    size_t capacity;
+    int64_t origin_ns;
+    mutex buffers_mutex;  // 仅在线程首次记录时注册缓冲区使用
+    vector<unique_ptr<ThreadBuffer>> buffers;
+
+    // 卡顿导出: 整帧耗时超过阈值时立即导出当前缓冲区, 长时间运行时卡顿现场不会被环形缓冲区覆盖
+    static const int kMaxStallDumps = 32;  // 导出文件数上限, 避免持续卡顿写满磁盘
+    int64_t stall_ns;      // 阈值(<=0 关闭)
+    string stall_prefix;   // 导出路径前缀, 文件名为 <前缀>.stall-<帧号>.json
+    int stall_dumps;
+
+    FrameTracer();
+    ThreadBuffer* threadBuffer();
+    void dumpStall(int frame, int64_t dur_ns);
+
+public:
+    static FrameTracer& instance();
+    static int64_t nowNs();
+    static const char* stageName(TraceStage stage);
+
+    void enable(size_t events_per_thread);
+    bool enabled() const { return enabled_.load(memory_order_relaxed); }
+    void setFrame(int frame) { current_frame.store(frame, memory_order_relaxed); }
+    void record(TraceStage stage, int64_t start_ns, int64_t end_ns);
+
+    // 整帧(TRACE_FRAME)耗时达到 threshold_ms 时导出当前缓冲区到 <path_prefix>.stall-<帧号>.json
+    // 整帧事件在帧末由主线程记录, 此时各阶段(含条带并行的工作线程)均已结束
+    void setStallDump(double threshold_ms, const string& path_prefix);
+
+    // 导出 Chrome trace-event JSON, 调用时各线程应已停止记录
+    bool writeChromeTrace(const string& path);
+
+    // 按阶段汇总缓冲区内事件的总耗时(毫秒)与次数, 调用时各线程应已停止记录
+    void summarize(vector<double>& total_ms, vector<uint64_t>& counts);
+    // 清空所有线程缓冲区, 调用时各线程应已停止记录
+    void clear();
+};
+
+// RAII 阶段计时: 构造时开始, 析构时记录; 追踪关闭时只有一次判断开销
+class TraceScope {
+private:
+    TraceStage stage;
+    int64_t start_ns;
+
+public:
+    explicit TraceScope(TraceStage s)
+        : stage(s),
+          start_ns(FrameTracer::instance().enabled() ? FrameTracer::nowNs() : -1) {}
+
+    // 放弃本次记录(如读取失败、没有实际处理的解码)
+    void cancel() { start_ns = -1; }
+
+    ~TraceScope() {
+        if (start_ns >= 0) {
+            FrameTracer::instance().record(stage, start_ns, FrameTracer::nowNs());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+#endif // FRAME_TRACER_H
@@ -0,0 +1,287 @@
+/**
+ * 流水线产品质量检测系统 - 二进制检测记录实现文件
+ * 检测、轨迹与计数记录的定长二进制编码, 以及逐帧写入/读取的记录文件(用于日志、回放与跨线程传递)
+ */
+
+#include "inspection_log.h"
+#include <algorithm>
+#include <cstring>
+
+static const char kLogMagic[4] = {'C', 'V', 'I', 'L'};
+static const uint32_t kLogVersion = 1;
+static const size_t kFrameHeaderBytes = 10;
+
+// ============================================================================
+// 小端字段读写
+// ============================================================================
+
+static uint8_t* putU16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    return p + 2;
+}
+
+static uint8_t* putU32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+    return p + 4;
+}
+
+static uint8_t* putI32(uint8_t* p, int32_t v) {
+    return putU32(p, static_cast<uint32_t>(v));
+}
+
+static uint8_t* putF32(uint8_t* p, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return putU32(p, bits);
+}
+
+static uint8_t* putPoint(uint8_t* p, const Point2f& pt) {
+    return putF32(putF32(p, pt.x), pt.y);
+}
+
+static uint16_t getU16(const uint8_t*& p) {
+    uint16_t v = static_cast<uint16_t>(p[0] | (p[1] << 8));
+    p += 2;
+    return v;
+}
+
+static uint32_t getU32(const uint8_t*& p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+        v |= static_cast<uint32_t>(p[i]) << (8 * i);
+    }
+    p += 4;
+    return v;
+}
+
+static int32_t getI32(const uint8_t*& p) {
+    return static_cast<int32_t>(getU32(p));
+}
+
+static float getF32(const uint8_t*& p) {
+    uint32_t bits = getU32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+static Point2f getPoint(const uint8_t*& p) {
+    float x = getF32(p);
+    float y = getF32(p);
+    return Point2f(x, y);
+}
+
+static bool getType(const uint8_t*& p, ProductType& type) {
+    uint8_t v = *p++;
+    if (v > static_cast<uint8_t>(ProductType::Defective)) {
+        return false;
+    }
+    type = static_cast<ProductType>(v);
+    return true;
+}
+
+// ============================================================================
+// 定长记录编解码
+// ============================================================================
+
+size_t encodeRecord(const Detection& det, uint8_t* out) {
+    uint8_t* p = out;
+    *p++ = static_cast<uint8_t>(det.type);
+    p = putPoint(p, det.centroid);
+    p = putF32(p, det.angle);
+    p = putF32(p, det.scale);
+    p = putPoint(p, det.rect.center);
+    p = putF32(p, det.rect.size.width);
+    p = putF32(p, det.rect.size.height);
+    p = putF32(p, det.rect.angle);
+    for (const auto& pt : det.box) {
+        p = putPoint(p, pt);
+    }
+    return static_cast<size_t>(p - out);
+}
+
+size_t encodeRecord(const TrackedProduct& track, uint8_t* out) {
+    uint8_t* p = out;
+    p = putI32(p, track.id);
+    p = putPoint(p, track.centroid);
+    p = putPoint(p, track.prev_centroid);
+    p = putPoint(p, track.initial_pos);
+    p = putI32(p, track.frames_tracked);
+    p = putI32(p, track.frames_lost);
+    *p++ = track.counted ? 1 : 0;
+    p = putI32(p, track.det_index);
+    *p++ = static_cast<uint8_t>(track.type);
+    p = putF32(p, track.angle);
+    p = putF32(p, track.scale);
+    return static_cast<size_t>(p - out);
+}
+
+size_t encodeRecord(const CountedProduct& product, uint8_t* out) {
+    uint8_t* p = out;
+    p = putI32(p, product.id);
+    *p++ = static_cast<uint8_t>(product.type);
+    p = putF32(p, product.angle);
+    p = putF32(p, product.scale);
+    p = putI32(p, product.frame);
+    return static_cast<size_t>(p - out);
+}
+
+bool decodeRecord(const uint8_t* in, Detection& det) {
+    const uint8_t* p = in;
+    if (!getType(p, det.type)) {
+        return false;
+    }
+    det.centroid = getPoint(p);
+    det.angle = getF32(p);
+    det.scale = getF32(p);
+    det.rect.center = getPoint(p);
+    det.rect.size.width = getF32(p);
+    det.rect.size.height = getF32(p);
+    det.rect.angle = getF32(p);
+    for (auto& pt : det.box) {
+        pt = getPoint(p);
+    }
+    return true;
+}
+
+bool decodeRecord(const uint8_t* in, TrackedProduct& track) {
+    const uint8_t* p = in;
+    track.id = getI32(p);
+    track.centroid = getPoint(p);
+    track.prev_centroid = getPoint(p);
+    track.initial_pos = getPoint(p);
+    track.frames_tracked = getI32(p);
+    track.frames_lost = getI32(p);
+    track.counted = *p++ != 0;
+    track.det_index = getI32(p);
+    if (!getType(p, track.type)) {
+        return false;
+    }
+    track.angle = getF32(p);
+    track.scale = getF32(p);
+    return true;
+}
+
+bool decodeRecord(const uint8_t* in, CountedProduct& product) {
+    const uint8_t* p = in;
+    product.id = getI32(p);
+    if (!getType(p, product.type)) {
+        return false;
+    }
+    product.angle = getF32(p);
+    product.scale = getF32(p);
+    product.frame = getI32(p);
+    return true;
+}
+
+// ============================================================================
+// InspectionLogWriter
+// ============================================================================
+
+bool InspectionLogWriter::open(const string& path) {
+    out.open(path, ios::binary | ios::trunc);
+    if (!out.is_open()) {
+        return false;
+    }
+    uint8_t header[8];
+    memcpy(header, kLogMagic, 4);
+    putU32(header + 4, kLogVersion);
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    return out.good();
+}
+
+void InspectionLogWriter::writeFrame(int frame, const vector<Detection>& detections,
+                                     const TrackTable& tracks,
+                                     const CountedProduct* counted, size_t counted_size) {
+    // 单帧数量远小于 65535, 超出部分截断
+    size_t num_det = min(detections.size(), static_cast<size_t>(UINT16_MAX));
+    size_t num_tracks = min(tracks.size(), static_cast<size_t>(UINT16_MAX));
+    size_t num_counted = min(counted_size, static_cast<size_t>(UINT16_MAX));
+
+    buffer.resize(kFrameHeaderBytes + num_det * kDetectionRecordBytes +
+                  num_tracks * kTrackRecordBytes + num_counted * kCountedRecordBytes);
+    uint8_t* p = buffer.data();
+    p = putU32(p, static_cast<uint32_t>(frame));
+    p = putU16(p, static_cast<uint16_t>(num_det));
+    p = putU16(p, static_cast<uint16_t>(num_tracks));
+    p = putU16(p, static_cast<uint16_t>(num_counted));
+    for (size_t i = 0; i < num_det; i++) {
+        p += encodeRecord(detections[i], p);
+    }
+    for (size_t i = 0; i < num_tracks; i++) {
+        p += encodeRecord(tracks.row(i), p);
+    }
+    for (size_t i = 0; i < num_counted; i++) {
+        p += encodeRecord(counted[i], p);
+    }
+
+    out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<streamsize>(buffer.size()));
+}
+
+bool InspectionLogWriter::close() {
+    if (!out.is_open()) {
+        return false;
+    }
+    out.flush();
+    bool ok = out.good();
+    out.close();
+    return ok;
+}
+
+// ============================================================================
+// InspectionLogReader
+// ============================================================================
+
+bool InspectionLogReader::open(const string& path) {
+    in.open(path, ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+    uint8_t header[8];
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        memcmp(header, kLogMagic, 4) != 0) {
+        return false;
+    }
+    const uint8_t* p = header + 4;
+    return getU32(p) == kLogVersion;
+}
+
+bool InspectionLogReader::next(InspectionFrame& frame) {
+    uint8_t header[kFrameHeaderBytes];
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header))) {
+        return false;
+    }
+    const uint8_t* p = header;
+    frame.frame = static_cast<int>(getU32(p));
+    size_t num_det = getU16(p);
+    size_t num_tracks = getU16(p);
+    size_t num_counted = getU16(p);
+
+    buffer.resize(num_det * kDetectionRecordBytes + num_tracks * kTrackRecordBytes +
+                  num_counted * kCountedRecordBytes);
+    if (!buffer.empty() &&
+        !in.read(reinterpret_cast<char*>(buffer.data()), static_cast<streamsize>(buffer.size()))) {
+        return false;
+    }
+
+    p = buffer.data();
+    frame.detections.resize(num_det);
+    for (auto& det : frame.detections) {
+        if (!decodeRecord(p, det)) return false;
+        p += kDetectionRecordBytes;
+    }
+    frame.tracks.resize(num_tracks);
+    for (auto& track : frame.tracks) {
+        if (!decodeRecord(p, track)) return false;
+        p += kTrackRecordBytes;
+    }
+    frame.counted.resize(num_counted);
+    for (auto& product : frame.counted) {
+        if (!decodeRecord(p, product)) return false;
+        p += kCountedRecordBytes;
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+/**
+ * 流水线产品质量检测系统 - 二进制检测记录头文件
+ * 检测、轨迹与计数记录的定长二进制编码, 以及逐帧写入/读取的记录文件(用于日志、回放与跨线程传递)
+ */
+
+#ifndef INSPECTION_LOG_H
+#define INSPECTION_LOG_H
+
+#include "conveyor_inspector.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// 定长记录字节数(小端序, 与结构体内存布局和编译器填充无关)
+static const size_t kDetectionRecordBytes = 69;
+static const size_t kTrackRecordBytes = 50;
+static const size_t kCountedRecordBytes = 17;
+
+// 编码到 out(需预留对应的字节数), 返回写入字节数
+size_t encodeRecord(const Detection& det, uint8_t* out);
+size_t encodeRecord(const TrackedProduct& track, uint8_t* out);
+size_t encodeRecord(const CountedProduct& product, uint8_t* out);
+
+// 从 in 解码(调用方保证剩余字节数足够); 类型字节非法时返回 false
+bool decodeRecord(const uint8_t* in, Detection& det);
+bool decodeRecord(const uint8_t* in, TrackedProduct& track);
+bool decodeRecord(const uint8_t* in, CountedProduct& product);
+
+// 一帧的记录
+struct InspectionFrame {
+    int frame;
+    vector<Detection> detections;
+    vector<TrackedProduct> tracks;
+    vector<CountedProduct> counted;   // 本帧新统计的产品
+};
+
+// 记录文件: 文件头 "CVIL" + 版本号, 之后每帧一个块:
+//   帧号(u32) 检测数(u16) 轨迹数(u16) 计数数(u16) + 各定长记录
+class InspectionLogWriter {
+private:
+    ofstream out;
+    vector<uint8_t> buffer;  // 复用的帧编码缓冲区
+
+public:
+    bool open(const string& path);
+    void writeFrame(int frame, const vector<Detection>& detections, const TrackTable& tracks,
+                    const CountedProduct* counted, size_t counted_size);
+    bool close();
+};
+
+class InspectionLogReader {
+private:
+    ifstream in;
+    vector<uint8_t> buffer;
+
+public:
+    bool open(const string& path);
+    // 读取下一帧; 到达文件末尾或记录损坏时返回 false
+    bool next(InspectionFrame& frame);
+};
+
+#endif // INSPECTION_LOG_H
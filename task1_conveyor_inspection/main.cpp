@@ -4,7 +4,12 @@
  */
 
 #include "conveyor_inspector.h"
+#include "frame_tracer.h"
+#include "inspection_log.h"
 #include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
 
 using namespace std;
 
@@ -12,13 +17,23 @@ void printUsage(const char* program_name) {
     cout << "流水线产品质量检测系统 v1.0" << endl;
     cout << endl;
     cout << "用法: " << program_name << " <视频路径> [选项]" << endl;
+    cout << "      " << program_name << " --replay <记录文件>" << endl;
     cout << endl;
     cout << "选项:" << endl;
     cout << "  --no-show        禁用视频播放窗口（仅统计）" << endl;
+    cout << "  --gate <坐标>    设置虚拟计数门, 格式 x1,y1,x2,y2[,x3,y3,...]" << endl;
+    cout << "                   2个顶点为计数线, 3个及以上为计数多边形" << endl;
+    cout << "  --striped        按水平条带多核并行执行掩码与形态学(结果与整帧一致)" << endl;
+    cout << "  --trace <路径>   记录每帧各阶段耗时, 导出 Chrome trace JSON (Perfetto 可查看)" << endl;
+    cout << "  --trace-capacity <N>  每线程保留的最近追踪事件数(默认 65536)" << endl;
+    cout << "  --trace-stall-ms <毫秒>  单帧耗时超过该值时立即导出当前追踪缓冲区" << endl;
+    cout << "                   到 <trace路径>.stall-<帧号>.json (默认 100, 0 关闭)" << endl;
+    cout << "  --record <路径>  逐帧写入检测、轨迹与计数事件的二进制记录(--replay 回放)" << endl;
     cout << endl;
     cout << "示例:" << endl;
     cout << "  " << program_name << " video/1.mp4                    # 实时播放（默认）" << endl;
     cout << "  " << program_name << " video/1.mp4 --no-show          # 仅统计" << endl;
+    cout << "  " << program_name << " video/1.mp4 --gate 640,0,640,720  # 竖直计数线" << endl;
     cout << endl;
     cout << "播放控制:" << endl;
     cout << "  ESC 或 q   - 退出播放" << endl;
@@ -27,6 +42,62 @@ void printUsage(const char* program_name) {
     cout << endl;
 }
 
+// 解析计数门坐标 "x1,y1,x2,y2,..."
+bool parseGatePoints(const string& text, vector<Point2f>& points) {
+    vector<float> values;
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ',')) {
+        stringstream item_ss(item);
+        float v;
+        if (!(item_ss >> v)) {
+            return false;
+        }
+        values.push_back(v);
+    }
+
+    if (values.size() < 4 || values.size() % 2 != 0) {
+        return false;
+    }
+
+    points.clear();
+    for (size_t i = 0; i < values.size(); i += 2) {
+        points.push_back(Point2f(values[i], values[i + 1]));
+    }
+    return true;
+}
+
+// 回放二进制记录: 不解码视频, 重新输出计数事件与统计
+int runReplay(const string& record_path) {
+    InspectionLogReader reader;
+    if (!reader.open(record_path)) {
+        cerr << "错误: 无法读取检测记录 " << record_path << endl;
+        return -1;
+    }
+
+    InspectionFrame frame;
+    int frames = 0, qualified = 0, defective = 0;
+    size_t detections = 0;
+    while (reader.next(frame)) {
+        frames++;
+        detections += frame.detections.size();
+        for (const auto& prod : frame.counted) {
+            if (prod.type == ProductType::Qualified) {
+                qualified++;
+            } else {
+                defective++;
+            }
+            cout << "Frame " << prod.frame << ": " << productTypeName(prod.type)
+                 << " ID:" << prod.id << ", Angle: " << fixed << setprecision(1) << prod.angle
+                 << "°, Scale: " << setprecision(2) << prod.scale << "x" << endl;
+        }
+    }
+
+    cout << "回放完成: " << frames << " 帧, " << detections << " 个检测, 合格品 " << qualified
+         << ", 次品 " << defective << ", 总计 " << (qualified + defective) << endl;
+    return 0;
+}
+
 int main(int argc, char** argv) {
     // 检查参数
     if (argc < 2) {
@@ -34,21 +105,90 @@ int main(int argc, char** argv) {
         return -1;
     }
 
+    if (string(argv[1]) == "--replay") {
+        if (argc < 3) {
+            printUsage(argv[0]);
+            return -1;
+        }
+        return runReplay(argv[2]);
+    }
+
     string video_path = argv[1];
     bool show_video = true;  // 默认启用显示
+    vector<Point2f> gate_points;
+    bool striped = false;
+    string trace_path = "";
+    size_t trace_capacity = 1 << 16;  // 每线程最多约1.5MB(按需分块分配), 30fps 下约可覆盖最近三分钟
+    double trace_stall_ms = 100.0;     // 卡顿现场在被覆盖前导出
+    string record_path = "";
 
     // 解析选项
     for (int i = 2; i < argc; i++) {
         string arg = argv[i];
         if (arg == "--no-show") {
             show_video = false;  // 使用 --no-show 禁用显示
+        } else if (arg == "--gate" && i + 1 < argc) {
+            if (!parseGatePoints(argv[i + 1], gate_points)) {
+                cerr << "错误: 无效的计数门坐标: " << argv[i + 1] << endl;
+                return -1;
+            }
+            i++;  // 跳过下一个参数
+        } else if (arg == "--striped") {
+            striped = true;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_path = argv[i + 1];
+            i++;
+        } else if (arg == "--trace-capacity" && i + 1 < argc) {
+            long capacity = atol(argv[i + 1]);
+            if (capacity <= 0) {
+                cerr << "错误: 无效的追踪事件数: " << argv[i + 1] << endl;
+                return -1;
+            }
+            trace_capacity = static_cast<size_t>(capacity);
+            i++;
+        } else if (arg == "--trace-stall-ms" && i + 1 < argc) {
+            trace_stall_ms = atof(argv[i + 1]);
+            if (trace_stall_ms < 0) {
+                cerr << "错误: 无效的卡顿阈值: " << argv[i + 1] << endl;
+                return -1;
+            }
+            i++;
+        } else if (arg == "--record" && i + 1 < argc) {
+            record_path = argv[i + 1];
+            i++;
+        }
+    }
+
+    if (!trace_path.empty()) {
+        FrameTracer::instance().enable(trace_capacity);
+        // 卡顿导出文件与 --trace 文件同名前缀(去掉 .json 扩展名)
+        string prefix = trace_path;
+        if (prefix.size() > 5 && prefix.compare(prefix.size() - 5, 5, ".json") == 0) {
+            prefix.erase(prefix.size() - 5);
         }
+        FrameTracer::instance().setStallDump(trace_stall_ms, prefix);
     }
 
     // 创建检测器并处理视频
     ConveyorInspector inspector;
+    if (!gate_points.empty()) {
+        inspector.setCountingGate(gate_points);
+    }
+    inspector.setStripedMorphology(striped);
+    if (!record_path.empty() && !inspector.setRecordPath(record_path)) {
+        cerr << "错误: 无法创建检测记录 " << record_path << endl;
+        return -1;
+    }
     inspector.processVideo(video_path, show_video);
     inspector.printStatistics(video_path);
 
+    if (!trace_path.empty()) {
+        if (FrameTracer::instance().writeChromeTrace(trace_path)) {
+            cout << "追踪数据已导出: " << trace_path << endl;
+        } else {
+            cerr << "错误: 无法写入追踪文件 " << trace_path << endl;
+        }
+    }
+
     return 0;
 }
@@ -0,0 +1,74 @@
+/**
+ * 公式识别系统 - 条带图像源头文件
+ * 按水平条带逐段提供灰度图像, 用于超高页面的有界内存识别
+ */
+
+#ifndef BAND_SOURCE_H
+#define BAND_SOURCE_H
+
+#include <opencv2/opencv.hpp>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+// 条带图像源: 自上而下逐条带读取灰度图像
+class BandSource {
+public:
+    virtual ~BandSource() {}
+
+    virtual int width() const = 0;
+    virtual int height() const = 0;
+
+    // 整页 256 级灰度直方图(全局大津阈值用), 需额外遍历一遍数据, 之后从页首开始读取条带
+    virtual bool histogram(vector<int>& hist) = 0;
+
+    // 读取下一条带(最多 maxRows 行, CV_8UC1), 已读完时返回 false
+    virtual bool nextBand(int maxRows, Mat& band) = 0;
+};
+
+// 已解码图像: 逐条带转灰度, 不生成整页灰度/二值副本
+class MatBandSource : public BandSource {
+private:
+    Mat image;
+    int next_row;
+
+public:
+    explicit MatBandSource(const Mat& image);
+
+    int width() const override;
+    int height() const override;
+    bool histogram(vector<int>& hist) override;
+    bool nextBand(int maxRows, Mat& band) override;
+};
+
+// 二进制 PGM(P5, 8 位)文件: 直接从磁盘逐条带读取, 内存与页面高度无关
+class PgmBandSource : public BandSource {
+private:
+    ifstream file;
+    streampos data_start;
+    int cols;
+    int rows;
+    int next_row;
+
+public:
+    PgmBandSource();
+
+    bool open(const string& path);
+    int width() const override;
+    int height() const override;
+    bool histogram(vector<int>& hist) override;
+    bool nextBand(int maxRows, Mat& band) override;
+};
+
+// 按扩展名选择图像源: .pgm 流式读取; 其余格式经 imgcodecs 以灰度解码整页(无法分段解码)
+// 打开失败返回空指针
+unique_ptr<BandSource> openBandSource(const string& path);
+
+// 由直方图计算大津阈值(与 cv::threshold 的 THRESH_OTSU 结果一致)
+double otsuThreshold(const vector<int>& hist);
+
+#endif // BAND_SOURCE_H
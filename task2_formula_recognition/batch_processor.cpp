@@ -0,0 +1,241 @@
+/**
+ * 公式识别系统 - 批量处理实现文件
+ * I/O 线程解码图片, 工作线程池并发识别, 结果按输入顺序汇总
+ */
+
+#include "batch_processor.h"
+#include "formula_json.h"
+#include "mat_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <sys/stat.h>
+
+// 解码队列容量(每个识别线程预留的已解码图片数), 限制内存占用
+static const size_t kQueueSlotsPerWorker = 2;
+
+BatchOptions::BatchOptions()
+    : io_threads(2), workers(max(1, (int)thread::hardware_concurrency())),
+      multi_mode(true), write_images(false), result_cache(nullptr),
+      profile(false), mat_pool(false) {}
+
+string resultImagePath(const string& image_path) {
+    size_t lastSlash = image_path.find_last_of("/\\");
+    size_t lastDot = image_path.find_last_of(".");
+
+    string baseDir = (lastSlash != string::npos) ? image_path.substr(0, lastSlash + 1) : "";
+    string baseName = (lastSlash != string::npos) ? image_path.substr(lastSlash + 1) : image_path;
+
+    if (lastDot != string::npos && (lastSlash == string::npos || lastDot > lastSlash)) {
+        baseName = baseName.substr(0, lastDot - (lastSlash != string::npos ? lastSlash + 1 : 0));
+    }
+
+    return baseDir + baseName + "_result.png";
+}
+
+// ============================================================================
+// BatchProcessor 类实现
+// ============================================================================
+
+BatchProcessor::BatchProcessor(const FormulaRecognizer& rec, const BatchOptions& opts)
+    : recognizer(rec), options(opts) {}
+
+static bool isImageFile(const string& path) {
+    size_t dot = path.find_last_of('.');
+    if (dot == string::npos) return false;
+
+    string ext = path.substr(dot + 1);
+    transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == "png" || ext == "jpg" || ext == "jpeg" || ext == "bmp" ||
+           ext == "tif" || ext == "tiff";
+}
+
+vector<string> BatchProcessor::collectInputs(const string& spec) {
+    vector<string> paths;
+
+    struct stat st;
+    bool is_dir = stat(spec.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+
+    if (is_dir || spec.find_first_of("*?") != string::npos) {
+        vector<String> files;
+        glob(spec, files, false);
+        for (const auto& f : files) {
+            // 目录模式下跳过图片格式以外的文件和之前生成的结果图片
+            if (is_dir && (!isImageFile(f) || f.find("_result.") != string::npos)) continue;
+            paths.push_back(f);
+        }
+        sort(paths.begin(), paths.end());
+    } else {
+        // 列表文件: 每行一个路径, 忽略空行和 # 注释
+        ifstream in(spec);
+        string line;
+        while (getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+            paths.push_back(line);
+        }
+    }
+
+    return paths;
+}
+
+// RAII: 作用范围内把 OpenCV 的线程数设为 threads, 析构时恢复
+// OpenCV 线程数是进程级的; 多个识别线程已占满核心时, 行级 parallel_for_ 与 OpenCV 内部并行只会超额订阅
+class OpenCVThreadsScope {
+private:
+    int previous;
+
+public:
+    explicit OpenCVThreadsScope(int threads) : previous(getNumThreads()) {
+        setNumThreads(threads);
+    }
+    ~OpenCVThreadsScope() {
+        setNumThreads(previous);
+    }
+
+    OpenCVThreadsScope(const OpenCVThreadsScope&) = delete;
+    OpenCVThreadsScope& operator=(const OpenCVThreadsScope&) = delete;
+};
+
+vector<BatchItem> BatchProcessor::run(const vector<string>& paths) {
+    vector<BatchItem> items(paths.size());
+    for (size_t i = 0; i < paths.size(); i++) {
+        items[i].path = paths[i];
+    }
+
+    int workers = max(1, options.workers);
+    int io_threads = max(1, options.io_threads);
+    size_t queue_capacity = kQueueSlotsPerWorker * workers;
+
+    // 解码线程 -> 识别线程 的有界队列
+    struct Task {
+        size_t index;
+        Mat image;
+        string cache_key;  // 未启用结果缓存时为空
+    };
+    mutex queue_mutex;
+    condition_variable not_empty, not_full;
+    deque<Task> queue;
+    int producers_left = io_threads;
+    atomic<size_t> next_input(0);
+    ResultCache* cache = options.result_cache;
+
+    // 多个识别线程时每张图片在本线程内串行识别(行级 parallel_for_ 与 OpenCV 内部算子均不再并行);
+    // 只有一个识别线程时保留行级并行
+    unique_ptr<OpenCVThreadsScope> opencv_threads;
+    if (workers > 1) {
+        opencv_threads.reset(new OpenCVThreadsScope(1));
+    }
+
+    // 解码与识别线程新建的 Mat 都从内存池分配; 各线程的空闲块在图片之间复用
+    unique_ptr<MatPoolScope> mat_pool;
+    if (options.mat_pool) {
+        mat_pool.reset(new MatPoolScope());
+    }
+
+    auto decode = [&]() {
+        size_t i;
+        while ((i = next_input.fetch_add(1)) < paths.size()) {
+            Task task;
+            task.index = i;
+            if (cache == nullptr) {
+                task.image = imread(paths[i]);
+            } else {
+                // 先按文件字节查缓存, 命中则不解码也不进入识别队列
+                // 需要生成结果图片时不查缓存(缓存中只有 JSON, 没有可绘制的图像), 识别后仍写入缓存
+                vector<uchar> data;
+                if (readFileBytes(paths[i], data) && !data.empty()) {
+                    task.cache_key = cache->keyFor(data, options.multi_mode);
+                    if (!options.write_images && cache->lookup(task.cache_key, items[i].cached_json)) {
+                        continue;
+                    }
+                    task.image = imdecode(data, IMREAD_COLOR);
+                }
+            }
+            if (task.image.empty()) {
+                items[i].error = "无法读取图像";
+                continue;
+            }
+
+            unique_lock<mutex> lock(queue_mutex);
+            not_full.wait(lock, [&]() { return queue.size() < queue_capacity; });
+            queue.push_back(task);
+            not_empty.notify_one();
+        }
+
+        lock_guard<mutex> lock(queue_mutex);
+        producers_left--;
+        not_empty.notify_all();
+    };
+
+    auto recognize = [&]() {
+        while (true) {
+            Task task;
+            {
+                unique_lock<mutex> lock(queue_mutex);
+                not_empty.wait(lock, [&]() { return !queue.empty() || producers_left == 0; });
+                if (queue.empty()) break;
+                task = queue.front();
+                queue.pop_front();
+                not_full.notify_one();
+            }
+
+            BatchItem& item = items[task.index];
+            const Mat& image = task.image;
+            RecognitionProfile* profile = options.profile ? &item.profile : nullptr;
+            if (options.multi_mode) {
+                item.results = recognizer.recognizeMultipleFormulas(image, profile);
+                if (options.write_images) {
+                    recognizer.writeMultipleResultsToImage(image, item.results,
+                                                           resultImagePath(item.path), profile);
+                }
+            } else {
+                item.results.push_back(recognizer.recognizeFormula(image, profile));
+                if (options.write_images) {
+                    recognizer.writeResultToImage(image, item.results[0],
+                                                  resultImagePath(item.path), profile);
+                }
+            }
+
+            if (!task.cache_key.empty()) {
+                cache->store(task.cache_key, formulasToJson(item.results));
+            }
+        }
+    };
+
+    vector<thread> threads;
+    for (int t = 0; t < io_threads; t++) threads.push_back(thread(decode));
+    for (int t = 0; t < workers; t++) threads.push_back(thread(recognize));
+    for (auto& t : threads) t.join();
+
+    return items;
+}
+
+bool BatchProcessor::writeResults(const string& path, const vector<BatchItem>& items) {
+    ofstream out(path);
+    if (!out.is_open()) {
+        return false;
+    }
+    for (const auto& item : items) {
+        if (!item.cached_json.empty()) {
+            out << imageFormulasToJson(item.path, item.cached_json) << "\n";
+        } else {
+            out << imageResultsToJson(item.path, item.results, item.error,
+                                      item.profile.images > 0 ? &item.profile : nullptr) << "\n";
+        }
+    }
+    return out.good();
+}
+
+RecognitionProfile BatchProcessor::aggregateProfile(const vector<BatchItem>& items) {
+    RecognitionProfile total;
+    for (const auto& item : items) {
+        total.merge(item.profile);
+    }
+    return total;
+}
@@ -0,0 +1,62 @@
+/**
+ * 公式识别系统 - 批量处理头文件
+ * I/O 线程解码图片, 工作线程池并发识别, 结果按输入顺序汇总
+ */
+
+#ifndef BATCH_PROCESSOR_H
+#define BATCH_PROCESSOR_H
+
+#include "formula_recognizer.h"
+#include "result_cache.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// 批量处理选项
+struct BatchOptions {
+    int io_threads;        // 解码线程数
+    int workers;           // 识别线程数
+    bool multi_mode;       // 多公式识别(与单图模式默认一致)
+    bool write_images;     // 是否为每张图片生成 _result.png
+    ResultCache* result_cache;  // 磁盘结果缓存(为空时不使用), 命中的图片跳过解码与识别
+    bool profile;          // 记录每张图片的分阶段耗时
+    bool mat_pool;         // 处理期间使用 Mat 内存池(PooledMatAllocator)作为默认分配器
+
+    BatchOptions();
+};
+
+// 单张图片的批量处理结果
+struct BatchItem {
+    string path;                    // 图片路径
+    string error;                   // 非空表示处理失败
+    vector<FormulaResult> results;  // 识别结果(单公式模式下只有一个)
+    string cached_json;             // 结果缓存命中时的公式 JSON 数组(此时 results 为空)
+    RecognitionProfile profile;     // 分阶段耗时(启用 profile 且经过识别时 images 为 1)
+};
+
+// 批量处理器
+class BatchProcessor {
+private:
+    const FormulaRecognizer& recognizer;  // 共享识别器(无状态, 可并发调用)
+    BatchOptions options;
+
+public:
+    BatchProcessor(const FormulaRecognizer& recognizer, const BatchOptions& options);
+
+    // 输入可以是目录、通配符(如 "images/*.png")或每行一个路径的列表文件
+    static vector<string> collectInputs(const string& spec);
+
+    vector<BatchItem> run(const vector<string>& paths);
+
+    // 汇总结果写入单个文件(每行一个 JSON 对象, 有分阶段耗时的图片附带 timing_ms)
+    static bool writeResults(const string& path, const vector<BatchItem>& items);
+
+    // 合并所有图片的分阶段耗时
+    static RecognitionProfile aggregateProfile(const vector<BatchItem>& items);
+};
+
+// 结果图片默认路径: 原文件名_result.png
+string resultImagePath(const string& image_path);
+
+#endif // BATCH_PROCESSOR_H
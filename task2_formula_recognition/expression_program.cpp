@@ -0,0 +1,201 @@
+/**
+ * 公式识别系统 - 表达式编译与求值实现文件
+ * 识别出的表达式先编译为定长缓冲区中的逆波兰(RPN)指令序列, 再用定长栈求值, 全程不分配堆内存
+ */
+
+#include "expression_program.h"
+#include <cmath>
+#include <limits>
+
+const char* exprErrorMessage(ExprError error) {
+    switch (error) {
+        case EXPR_OK: return "";
+        case EXPR_EMPTY: return "空表达式";
+        case EXPR_UNEXPECTED_CHAR: return "无法识别的字符";
+        case EXPR_MISSING_OPERAND: return "缺少操作数";
+        case EXPR_MISSING_OPERATOR: return "缺少运算符";
+        case EXPR_UNBALANCED_PAREN: return "括号不匹配";
+        case EXPR_TOO_COMPLEX: return "表达式过长或嵌套过深";
+        case EXPR_DIVIDE_BY_ZERO: return "除数为 0";
+        case EXPR_NEGATIVE_SQRT: return "负数开方";
+    }
+    return "未知错误";
+}
+
+// ============================================================================
+// ExpressionProgram 编译
+// ============================================================================
+
+ExpressionProgram::ExpressionProgram()
+    : length(0), error(EXPR_EMPTY), errorPos(-1), text(nullptr), textLen(0), pos(0), depth(0) {}
+
+// 跳过空格后的当前字符, 到达末尾时返回 '\0'
+char ExpressionProgram::peek() {
+    while (pos < textLen && text[pos] == ' ') pos++;
+    return pos < textLen ? text[pos] : '\0';
+}
+
+bool ExpressionProgram::emit(ExprOpCode op, double value) {
+    if (length >= kMaxInstructions) {
+        return fail(EXPR_TOO_COMPLEX);
+    }
+    code[length].op = op;
+    code[length].value = value;
+    length++;
+    return true;
+}
+
+// 只记录第一个错误
+bool ExpressionProgram::fail(ExprError err) {
+    if (error == EXPR_OK) {
+        error = err;
+        errorPos = (int)pos;
+    }
+    return false;
+}
+
+bool ExpressionProgram::parseExpr() {
+    if (!parseTerm()) return false;
+    while (true) {
+        char c = peek();
+        if (c != '+' && c != '-') return true;
+        pos++;
+        if (!parseTerm()) return false;
+        if (!emit(c == '+' ? EXPR_OP_ADD : EXPR_OP_SUB)) return false;
+    }
+}
+
+bool ExpressionProgram::parseTerm() {
+    if (!parseUnary()) return false;
+    while (true) {
+        char c = peek();
+        if (c != 'x' && c != '*' && c != '/') return true;
+        pos++;
+        if (!parseUnary()) return false;
+        if (!emit(c == '/' ? EXPR_OP_DIV : EXPR_OP_MUL)) return false;
+    }
+}
+
+bool ExpressionProgram::parseUnary() {
+    char c = peek();
+    if (c != '-' && c != 's') {
+        return parsePrimary();
+    }
+
+    // 一元运算符可连续出现(如 "--3"、"s-4"), 同样受嵌套深度限制
+    if (++depth > kMaxNesting) return fail(EXPR_TOO_COMPLEX);
+    pos++;
+    bool ok = parseUnary() && emit(c == '-' ? EXPR_OP_NEG : EXPR_OP_SQRT);
+    depth--;
+    return ok;
+}
+
+bool ExpressionProgram::parsePrimary() {
+    char c = peek();
+
+    if (c >= '0' && c <= '9') {
+        double value = 0.0;
+        while (pos < textLen && text[pos] >= '0' && text[pos] <= '9') {
+            value = value * 10 + (text[pos] - '0');
+            pos++;
+        }
+        return emit(EXPR_OP_PUSH, value);
+    }
+
+    if (c == '(') {
+        if (++depth > kMaxNesting) return fail(EXPR_TOO_COMPLEX);
+        pos++;
+        if (!parseExpr()) return false;
+        if (peek() != ')') return fail(EXPR_UNBALANCED_PAREN);
+        pos++;
+        depth--;
+        return true;
+    }
+
+    if (c == '\0' || c == ')' || c == '+' || c == 'x' || c == '*' || c == '/') {
+        return fail(EXPR_MISSING_OPERAND);
+    }
+    return fail(EXPR_UNEXPECTED_CHAR);
+}
+
+ExprError ExpressionProgram::compile(const char* expr, size_t len) {
+    length = 0;
+    error = EXPR_OK;
+    errorPos = -1;
+    depth = 0;
+    text = expr;
+    pos = 0;
+
+    // 忽略末尾的等号(识别结果以等号结束)
+    while (len > 0 && expr[len - 1] == ' ') len--;
+    if (len > 0 && expr[len - 1] == '=') len--;
+    textLen = len;
+
+    if (peek() == '\0') {
+        fail(EXPR_EMPTY);
+        return error;
+    }
+
+    if (parseExpr() && pos < textLen) {
+        char c = peek();
+        if (c == ')') {
+            fail(EXPR_UNBALANCED_PAREN);
+        } else if ((c >= '0' && c <= '9') || c == '(' || c == 's') {
+            fail(EXPR_MISSING_OPERATOR);
+        } else {
+            fail(EXPR_UNEXPECTED_CHAR);
+        }
+    }
+
+    if (error != EXPR_OK) {
+        length = 0;
+    }
+    return error;
+}
+
+// ============================================================================
+// ExpressionProgram 求值
+// ============================================================================
+
+ExprError ExpressionProgram::evaluate(double& value) const {
+    value = numeric_limits<double>::quiet_NaN();
+    if (error != EXPR_OK) {
+        return error;
+    }
+
+    // 栈深度不超过指令数; 编译保证操作数个数正确
+    double stack[kMaxInstructions];
+    int top = 0;
+
+    for (int i = 0; i < length; i++) {
+        const ExprInstruction& ins = code[i];
+        switch (ins.op) {
+            case EXPR_OP_PUSH:
+                stack[top++] = ins.value;
+                break;
+            case EXPR_OP_NEG:
+                stack[top - 1] = -stack[top - 1];
+                break;
+            case EXPR_OP_SQRT:
+                if (stack[top - 1] < 0) return EXPR_NEGATIVE_SQRT;
+                stack[top - 1] = sqrt(stack[top - 1]);
+                break;
+            default: {
+                double b = stack[--top];
+                double& a = stack[top - 1];
+                switch (ins.op) {
+                    case EXPR_OP_ADD: a += b; break;
+                    case EXPR_OP_SUB: a -= b; break;
+                    case EXPR_OP_MUL: a *= b; break;
+                    default:
+                        if (b == 0) return EXPR_DIVIDE_BY_ZERO;
+                        a /= b;
+                        break;
+                }
+            }
+        }
+    }
+
+    value = stack[0];
+    return EXPR_OK;
+}
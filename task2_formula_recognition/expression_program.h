@@ -0,0 +1,94 @@
+/**
+ * 公式识别系统 - 表达式编译与求值头文件
+ * 识别出的表达式先编译为定长缓冲区中的逆波兰(RPN)指令序列, 再用定长栈求值, 全程不分配堆内存
+ */
+
+#ifndef EXPRESSION_PROGRAM_H
+#define EXPRESSION_PROGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// 编译/求值错误码
+enum ExprError {
+    EXPR_OK = 0,
+    EXPR_EMPTY,                // 空表达式
+    EXPR_UNEXPECTED_CHAR,      // 不属于字符集的字符
+    EXPR_MISSING_OPERAND,      // 运算符或根号后缺少操作数
+    EXPR_MISSING_OPERATOR,     // 两个操作数之间缺少运算符, 如 "2(3)"
+    EXPR_UNBALANCED_PAREN,     // 括号不匹配
+    EXPR_TOO_COMPLEX,          // 超出指令缓冲区或嵌套深度
+    EXPR_DIVIDE_BY_ZERO,       // 除数为 0
+    EXPR_NEGATIVE_SQRT         // 负数开方
+};
+
+// 错误描述(静态字符串)
+const char* exprErrorMessage(ExprError error);
+
+// RPN 指令
+enum ExprOpCode : uint8_t {
+    EXPR_OP_PUSH = 0,      // 压入常数
+    EXPR_OP_ADD,
+    EXPR_OP_SUB,
+    EXPR_OP_MUL,
+    EXPR_OP_DIV,
+    EXPR_OP_NEG,           // 一元负号
+    EXPR_OP_SQRT           // 根号(作用于紧随其后的操作数或括号子表达式)
+};
+
+struct ExprInstruction {
+    double value;          // 仅 EXPR_OP_PUSH 使用
+    ExprOpCode op;
+};
+
+// 已编译的表达式
+// 文法(字符集与识别输出一致: x 或 * 乘, / 除, s 根号, 末尾的 = 忽略):
+//   expr  := term (('+' | '-') term)*
+//   term  := unary (('x' | '*' | '/') unary)*
+//   unary := '-' unary | 's' unary | primary
+//   primary := 数字 | '(' expr ')'
+// 对象本身即全部存储(约 2KB), 可放在栈上反复编译/求值
+class ExpressionProgram {
+public:
+    static const int kMaxInstructions = 128;
+    static const int kMaxNesting = 32;
+
+private:
+    ExprInstruction code[kMaxInstructions];
+    int length;
+    ExprError error;
+    int errorPos;          // 出错字符的下标(编译错误), 求值错误为 -1
+
+    // 递归下降解析器状态
+    const char* text;
+    size_t textLen;
+    size_t pos;
+    int depth;
+
+    char peek();
+    bool emit(ExprOpCode op, double value = 0.0);
+    bool fail(ExprError err);
+    bool parseExpr();
+    bool parseTerm();
+    bool parseUnary();
+    bool parsePrimary();
+
+public:
+    ExpressionProgram();
+
+    // 编译表达式; 失败时 errorPosition() 给出出错位置
+    ExprError compile(const char* expr, size_t len);
+    ExprError compile(const string& expr) { return compile(expr.data(), expr.size()); }
+
+    // 执行已编译的程序; 编译失败时直接返回编译错误
+    ExprError evaluate(double& value) const;
+
+    int size() const { return length; }
+    ExprError lastError() const { return error; }
+    int errorPosition() const { return errorPos; }
+};
+
+#endif // EXPRESSION_PROGRAM_H
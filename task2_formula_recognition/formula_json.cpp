@@ -0,0 +1,118 @@
+/**
+ * 公式识别系统 - 结果序列化实现文件
+ * 将识别结果输出为 JSON
+ */
+
+#include "formula_json.h"
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+string jsonEscape(const string& text) {
+    string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+            case '"':  escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    escaped += buf;
+                } else {
+                    escaped += c;
+                }
+        }
+    }
+    return escaped;
+}
+
+// 数值输出: 非有限值(如负数开方)输出为 null
+static string jsonNumber(double value) {
+    if (!std::isfinite(value)) {
+        return "null";
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.10g", value);
+    return buf;
+}
+
+// 耗时输出: 毫秒, 保留 3 位小数
+static string jsonMs(double ms) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.3f", ms);
+    return buf;
+}
+
+// 矩形输出为 [x,y,w,h]
+static string jsonRect(const Rect& box) {
+    stringstream ss;
+    ss << "[" << box.x << "," << box.y << "," << box.width << "," << box.height << "]";
+    return ss.str();
+}
+
+string formulaResultToJson(const FormulaResult& result) {
+    stringstream ss;
+    ss << "{\"expression\":\"" << jsonEscape(result.expression) << "\""
+       << ",\"result\":" << jsonNumber(result.result)
+       << ",\"box\":" << jsonRect(result.boundingBox)
+       << ",\"equals\":" << (result.equalsSignBox.width > 0 ? jsonRect(result.equalsSignBox) : "null");
+    if (!result.error.empty()) {
+        ss << ",\"error\":\"" << jsonEscape(result.error) << "\"";
+    }
+
+    ss << ",\"chars\":[";
+    for (size_t i = 0; i < result.characters.size(); i++) {
+        const RecognizedChar& ch = result.characters[i];
+        char confidence[16];
+        snprintf(confidence, sizeof(confidence), "%.3f", ch.confidence);
+        if (i > 0) ss << ",";
+        ss << "{\"char\":\"" << jsonEscape(string(1, ch.character)) << "\""
+           << ",\"box\":" << jsonRect(ch.boundingBox)
+           << ",\"confidence\":" << confidence << "}";
+    }
+    ss << "]}";
+    return ss.str();
+}
+
+string formulasToJson(const vector<FormulaResult>& results) {
+    stringstream ss;
+    ss << "[";
+    for (size_t i = 0; i < results.size(); i++) {
+        if (i > 0) ss << ",";
+        ss << formulaResultToJson(results[i]);
+    }
+    ss << "]";
+    return ss.str();
+}
+
+string profileToJson(const RecognitionProfile& profile) {
+    stringstream ss;
+    ss << "{";
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        RecognitionStage stage = static_cast<RecognitionStage>(i);
+        ss << "\"" << RecognitionProfile::stageName(stage) << "\":" << jsonMs(profile.stage_ms[i]) << ",";
+    }
+    ss << "\"total\":" << jsonMs(profile.totalMs()) << "}";
+    return ss.str();
+}
+
+string imageResultsToJson(const string& image_path, const vector<FormulaResult>& results,
+                          const string& error, const RecognitionProfile* profile) {
+    if (!error.empty()) {
+        return "{\"image\":\"" + jsonEscape(image_path) + "\",\"error\":\"" + jsonEscape(error) + "\"}";
+    }
+    string json = imageFormulasToJson(image_path, formulasToJson(results));
+    if (profile != nullptr) {
+        json.insert(json.size() - 1, ",\"timing_ms\":" + profileToJson(*profile));
+    }
+    return json;
+}
+
+string imageFormulasToJson(const string& image_path, const string& formulas_json) {
+    return "{\"image\":\"" + jsonEscape(image_path) + "\",\"formulas\":" + formulas_json + "}";
+}
@@ -0,0 +1,37 @@
+/**
+ * 公式识别系统 - 结果序列化头文件
+ * 将识别结果输出为 JSON
+ */
+
+#ifndef FORMULA_JSON_H
+#define FORMULA_JSON_H
+
+#include "formula_recognizer.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// JSON 字符串转义(不含两侧引号)
+string jsonEscape(const string& text);
+
+// 单个公式结果 -> JSON 对象
+// 包含表达式、计算结果、公式框、等号框(未识别到为 null)与逐字符的框和置信度, 矩形为 [x,y,w,h]
+// 表达式无法计算时 result 为 null 并附带 error 字段
+string formulaResultToJson(const FormulaResult& result);
+
+// 公式结果列表 -> JSON 数组
+string formulasToJson(const vector<FormulaResult>& results);
+
+// 分阶段耗时 -> JSON 对象 {"preprocess":ms,...,"total":ms}
+string profileToJson(const RecognitionProfile& profile);
+
+// 一张图片的全部结果 -> 单行 JSON 对象; error 非空时表示该图片处理失败
+// profile 非空时附加 "timing_ms" 字段
+string imageResultsToJson(const string& image_path, const vector<FormulaResult>& results,
+                          const string& error = "", const RecognitionProfile* profile = nullptr);
+
+// 以已序列化的公式数组(如结果缓存中的内容)构造图片结果, 与 imageResultsToJson 输出一致
+string imageFormulasToJson(const string& image_path, const string& formulas_json);
+
+#endif // FORMULA_JSON_H
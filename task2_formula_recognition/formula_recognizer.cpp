@@ -4,12 +4,18 @@
  */
 
 #include "formula_recognizer.h"
+#include "projection_profile.h"
+#include "layout_analysis.h"
+#include "result_cache.h"
 #include <iostream>
+#include <fstream>
 #include <iomanip>
 #include <sstream>
-#include <stack>
 #include <cmath>
 #include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <initializer_list>
 
 // ============================================================================
 // RecognizedChar 实现
@@ -22,13 +28,237 @@ bool RecognizedChar::operator<(const RecognizedChar& other) const {
     return boundingBox.x < other.boundingBox.x;
 }
 
+// 识别器版本: 规则、分割或表达式处理改变识别输出时递增, 使磁盘结果缓存失效
+static const char* const kRecognizerVersion = "formula-recognizer-2";
+
+// ============================================================================
+// 规则置信度: 每条规则由若干阈值约束组成, 裕量按特征尺度归一化
+// ============================================================================
+
+// 各特征的裕量尺度: 离阈值一个尺度即认为完全可信
+static const float kAspectScale = 0.1f;
+static const float kDensityScale = 0.05f;
+static const float kRatioScale = 0.05f;
+static const float kHeightScale = 4.0f;
+// 兜底分支不对应任何明确规则, 置信度封顶
+static const float kFallbackConfidence = 0.2f;
+// 低于该置信度的字形进入第二级模板匹配
+static const float kLowConfidence = 0.25f;
+
+// 单个阈值约束: 带符号的归一化裕量(满足时 >= 0)
+struct Constraint {
+    float margin;
+    bool pass;
+};
+
+static Constraint gt(float v, float threshold, float scale) {
+    return Constraint{(v - threshold) / scale, v > threshold};
+}
+
+static Constraint ge(float v, float threshold, float scale) {
+    return Constraint{(v - threshold) / scale, v >= threshold};
+}
+
+static Constraint lt(float v, float threshold, float scale) {
+    return Constraint{(threshold - v) / scale, v < threshold};
+}
+
+static Constraint le(float v, float threshold, float scale) {
+    return Constraint{(threshold - v) / scale, v <= threshold};
+}
+
+// 孔洞数为整数, 相差一个即为一个完整尺度
+static Constraint holesEq(int n, int k) {
+    return Constraint{n == k ? 1.0f : -(float)abs(n - k), n == k};
+}
+
+static Constraint holesGe(int n, int k) {
+    return Constraint{n >= k ? (float)(n - k + 1) : (float)(n - k), n >= k};
+}
+
+static Constraint holesLe(int n, int k) {
+    return Constraint{n <= k ? (float)(k - n + 1) : (float)(k - n), n <= k};
+}
+
+// 规则级联的置信度记录(定长数组, 不分配内存)
+// 置信度 = min(命中规则的最小裕量, 之前未命中且结果不同的规则离命中的距离)
+class RuleCascade {
+private:
+    static const int kMaxRules = 32;
+    char missChars[kMaxRules];
+    float missDistances[kMaxRules];  // 未命中规则中最大的违反量
+    int numMisses;
+    float margin;
+
+public:
+    RuleCascade() : numMisses(0), margin(0.0f) {}
+
+    bool match(char c, initializer_list<Constraint> constraints) {
+        float minMargin = 1.0f;
+        float maxViolation = 0.0f;
+        bool pass = true;
+        for (const auto& con : constraints) {
+            if (con.pass) {
+                minMargin = min(minMargin, max(con.margin, 0.0f));
+            } else {
+                pass = false;
+                maxViolation = max(maxViolation, -con.margin);
+            }
+        }
+
+        if (pass) {
+            margin = minMargin;
+            return true;
+        }
+        if (numMisses < kMaxRules) {
+            missChars[numMisses] = c;
+            missDistances[numMisses] = maxViolation;
+            numMisses++;
+        }
+        return false;
+    }
+
+    // 命中规则内部的二次判断(如左右括号)进一步限制裕量
+    void limit(float value) {
+        margin = min(margin, max(value, 0.0f));
+    }
+
+    float confidence(char result) const {
+        if (result == '?') return 0.0f;
+        float value = margin;
+        for (int i = 0; i < numMisses; i++) {
+            if (missChars[i] != result) {
+                value = min(value, missDistances[i]);
+            }
+        }
+        return min(value, 1.0f);
+    }
+};
+
 // ============================================================================
 // FormulaRecognizer 类实现
 // ============================================================================
 
-FormulaRecognizer::FormulaRecognizer() {}
+FormulaRecognizer::FormulaRecognizer() : logLevel(LOG_INFO), glyphBankHash(0) {}
 
-Mat FormulaRecognizer::preprocessImage(const Mat& input) {
+void FormulaRecognizer::setLogLevel(LogLevel level) {
+    logLevel = level;
+}
+
+void FormulaRecognizer::setVerbose(bool enabled) {
+    logLevel = enabled ? LOG_INFO : LOG_SILENT;
+}
+
+void FormulaRecognizer::enableGlyphCache(size_t capacity) {
+    if (capacity == 0) {
+        glyphCache.reset();
+    } else {
+        glyphCache = make_shared<GlyphCache>(capacity);
+    }
+}
+
+bool FormulaRecognizer::glyphCacheStats(GlyphCacheStats& stats) const {
+    if (!glyphCache) return false;
+    stats = glyphCache->stats();
+    return true;
+}
+
+string FormulaRecognizer::configFingerprint() const {
+    stringstream ss;
+    ss << kRecognizerVersion << "/bank=" << glyphBank.size()
+       << ":" << hex << setw(16) << setfill('0') << glyphBankHash
+       << "/glyph-cache=" << (glyphCache ? "on" : "off");
+    return ss.str();
+}
+
+int FormulaRecognizer::loadGlyphBank(const string& labelsPath) {
+    vector<unsigned char> labelBytes;
+    if (!readFileBytes(labelsPath, labelBytes)) {
+        return -1;
+    }
+    ifstream in(labelsPath);
+    if (!in.is_open()) {
+        return -1;
+    }
+    // 指纹覆盖标注内容与由图片得到的模板数据(图片改变时模板随之改变), 使用与结果缓存键相同的稳定哈希
+    glyphBankHash = ResultCache::hashBytes(labelBytes.data(), labelBytes.size(), glyphBankHash);
+
+    // 图片路径相对于标注文件所在目录
+    size_t slash = labelsPath.find_last_of("/\\");
+    string dir = slash == string::npos ? "" : labelsPath.substr(0, slash + 1);
+
+    int added = 0;
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        stringstream ss(line);
+        string file, joined, item;
+        ss >> file >> joined;
+        vector<string> expressions;
+        stringstream js(joined);
+        while (getline(js, item, ';')) {
+            expressions.push_back(item);
+        }
+
+        Mat image = imread(dir + file);
+        if (image.empty() || expressions.empty()) {
+            clog << "字形库: 跳过 " << file << " (无法读取图像或缺少标注)" << endl;
+            continue;
+        }
+
+        Mat binary = preprocessImage(image);
+        vector<Rect> rows = detectFormulaRows(binary);
+        if (rows.size() != expressions.size()) {
+            clog << "字形库: 跳过 " << file << " (检测到 " << rows.size() << " 行, 标注 "
+                 << expressions.size() << " 行)" << endl;
+            continue;
+        }
+
+        // 分割结果按 x 排序, 与标注逐个对应; 标注以 '=' 结尾时只对齐到等号(两条横线合并的字形),
+        // 之后的结果数字不参与。字形数必须与标注长度相等, 多出或缺少的噪声连通域会让之后的样本全部错位
+        for (size_t r = 0; r < rows.size(); r++) {
+            Mat labels;
+            vector<Glyph> glyphs = segmentGlyphs(binary(rows[r]), labels);
+            const string& expected = expressions[r];
+
+            size_t aligned = glyphs.size();
+            if (!expected.empty() && expected.back() == '=') {
+                for (size_t g = 0; g < glyphs.size(); g++) {
+                    if (glyphs[g].numLabels == 2) {
+                        aligned = g + 1;
+                        break;
+                    }
+                }
+            }
+            if (aligned != expected.size()) {
+                clog << "字形库: 跳过 " << file << " 第 " << (r + 1) << " 行 (字形数 " << aligned
+                     << ", 标注 \"" << expected << "\" 为 " << expected.size() << " 个字符)" << endl;
+                continue;
+            }
+
+            for (size_t i = 0; i < expected.size(); i++) {
+                GlyphTemplate tmpl;
+                extractGlyphTemplate(labels, glyphs[i], tmpl);
+                glyphBank.add(expected[i], tmpl);
+                glyphBankHash = ResultCache::hashBytes(&expected[i], 1, glyphBankHash);
+                glyphBankHash = ResultCache::hashBytes(tmpl.cells, sizeof(tmpl.cells), glyphBankHash);
+                glyphBankHash = ResultCache::hashBytes(&tmpl.aspectRatio, sizeof(tmpl.aspectRatio),
+                                                       glyphBankHash);
+                added++;
+            }
+        }
+    }
+
+    // 字形库改变了低置信度字形的分类结果, 已缓存的结果作废
+    if (glyphCache) {
+        glyphCache->clear();
+    }
+
+    return added;
+}
+
+Mat FormulaRecognizer::preprocessImage(const Mat& input) const {
     Mat gray, binary;
 
     if (input.channels() == 3) {
@@ -45,41 +275,23 @@ Mat FormulaRecognizer::preprocessImage(const Mat& input) {
     return binary;
 }
 
-char FormulaRecognizer::recognizeCharacter(const Mat& roi, const Rect& box) {
-    int h = roi.rows;
-    int w = roi.cols;
-
-    if (h == 0 || w == 0) return '?';
-
-    Mat resized;
-    resize(roi, resized, Size(28, 40));
+char FormulaRecognizer::recognizeCharacter(const GlyphFeatures& f, float& confidence) const {
+    confidence = 0.0f;
 
-    int pixelCount = countNonZero(resized);
-    float density = (float)pixelCount / (resized.rows * resized.cols);
-    float aspectRatio = (float)w / h;
+    int h = f.height;
+    int w = f.width;
 
-    vector<vector<Point>> contours;
-    findContours(resized.clone(), contours, RETR_LIST, CHAIN_APPROX_SIMPLE);
-    int numHoles = max(0, (int)contours.size() - 1);
+    if (h == 0 || w == 0 || f.totalPixels == 0) return '?';
 
-    int h1 = resized.rows / 3;
-    int h2 = resized.rows * 2 / 3;
-
-    Mat topPart = resized(Rect(0, 0, resized.cols, h1));
-    Mat midPart = resized(Rect(0, h1, resized.cols, h2 - h1));
-    Mat botPart = resized(Rect(0, h2, resized.cols, resized.rows - h2));
-
-    int topPixels = countNonZero(topPart);
-    int midPixels = countNonZero(midPart);
-    int botPixels = countNonZero(botPart);
-    int totalPixels = topPixels + midPixels + botPixels;
-
-    if (totalPixels == 0) return '?';
-
-    float topRatio = (float)topPixels / totalPixels;
-    float midRatio = (float)midPixels / totalPixels;
-    float botRatio = (float)botPixels / totalPixels;
+    float density = f.density;
+    float aspectRatio = f.aspectRatio;
+    int numHoles = f.numHoles;
+    float topRatio = f.topRatio;
+    float midRatio = f.midRatio;
+    float botRatio = f.botRatio;
 
+    const float A = kAspectScale, D = kDensityScale, R = kRatioScale, H = kHeightScale;
+    RuleCascade rules;
     char result = '?';
 
     // 运算符和括号识别 - 优先判断,避免与数字混淆
@@ -87,85 +299,84 @@ char FormulaRecognizer::recognizeCharacter(const Mat& roi, const Rect& box) {
     // 根号识别: 密度很低,中下部较重,顶部轻
     // 特征: AR:0.6-0.8, D:0.15-0.28, H:0, 中下部明显重于顶部
     // 与数字5区分: 根号密度更低,顶部更轻
-    if (aspectRatio > 0.6 && aspectRatio < 0.85 && density > 0.15 && density < 0.28 &&
-        numHoles == 0 && h > 35 && topRatio < 0.25 && (midRatio + botRatio) > 0.70) {
+    if (rules.match('s', {gt(aspectRatio, 0.6f, A), lt(aspectRatio, 0.85f, A),
+                          gt(density, 0.15f, D), lt(density, 0.28f, D), holesEq(numHoles, 0),
+                          gt(h, 35, H), lt(topRatio, 0.25f, R), gt(midRatio + botRatio, 0.70f, R)})) {
         result = 's';  // 用's'表示sqrt根号
     }
     // 括号识别: 细长,密度中等,无孔洞
     // 左括号(: aspectRatio小,密度0.45-0.55
     // 右括号): aspectRatio小,密度0.45-0.55
     // 关键: 括号比1粗(density>0.45),比3细(density<0.55)
-    else if (aspectRatio < 0.35 && density > 0.45 && density < 0.58 && numHoles == 0 && h > 30) {
+    else if (rules.match('(', {lt(aspectRatio, 0.35f, A), gt(density, 0.45f, D), lt(density, 0.58f, D),
+                               holesEq(numHoles, 0), gt(h, 30, H)})) {
         // 通过左右像素分布判断是左括号还是右括号
         // 左括号(: 左侧像素多(弯向右侧); 右括号): 右侧像素多(弯向左侧)
-        int leftPixels = 0, rightPixels = 0;
-        int halfW = w / 2;
-        for (int y = 0; y < h; y++) {
-            for (int x = 0; x < halfW; x++) {
-                if (roi.at<uchar>(y, x) == 255) leftPixels++;
-            }
-            for (int x = halfW; x < w; x++) {
-                if (roi.at<uchar>(y, x) == 255) rightPixels++;
-            }
-        }
-        if (leftPixels > rightPixels) {
+        if (f.leftPixels > f.rightPixels) {
             result = '(';
         } else {
             result = ')';
         }
+        rules.limit((float)abs(f.leftPixels - f.rightPixels) / (f.leftPixels + f.rightPixels) / R);
     }
     // 减号: 单条横线,高度很小,宽度很长,密度高(实心)
-    else if (h <= 10 && aspectRatio > 2.0 && density > 0.8) {
+    else if (rules.match('-', {le(h, 10, H), gt(aspectRatio, 2.0f, A), gt(density, 0.8f, D)})) {
         result = '-';
     }
     // 等号: 两条横线合并后的,或者单条但位置偏下
-    else if (h < 30 && h > 10 && aspectRatio > 1.5 && density > 0.4 && numHoles <= 1) {
+    else if (rules.match('=', {lt(h, 30, H), gt(h, 10, H), gt(aspectRatio, 1.5f, A),
+                               gt(density, 0.4f, D), holesLe(numHoles, 1)})) {
         result = '=';
     }
     // 加号: 正方形,密度低(中间有空洞但不算作hole)
-    else if (aspectRatio > 0.85 && aspectRatio < 1.15 && density > 0.2 && density < 0.35) {
+    else if (rules.match('+', {gt(aspectRatio, 0.85f, A), lt(aspectRatio, 1.15f, A),
+                               gt(density, 0.2f, D), lt(density, 0.35f, D)})) {
         result = '+';
     }
     // 乘号: 正方形或略宽,密度中等
-    else if (aspectRatio > 0.8 && aspectRatio < 1.2 && density > 0.4 && density < 0.65 && numHoles == 0 && h < 28) {
+    else if (rules.match('x', {gt(aspectRatio, 0.8f, A), lt(aspectRatio, 1.2f, A), gt(density, 0.4f, D),
+                               lt(density, 0.65f, D), holesEq(numHoles, 0), lt(h, 28, H)})) {
         result = 'x';
     }
     // 数字识别 - 按优先级从高到低,精确特征匹配
     // 1: 细长,低密度,无孔洞
-    else if (aspectRatio < 0.65 && density < 0.43 && numHoles == 0) {
+    else if (rules.match('1', {lt(aspectRatio, 0.65f, A), lt(density, 0.43f, D), holesEq(numHoles, 0)})) {
         result = '1';
     }
     // 1 (宽一点的字体): 细长,中等密度,无孔洞,中部最轻
-    else if (aspectRatio >= 0.65 && aspectRatio < 0.75 && density >= 0.43 && density < 0.55 &&
-             numHoles == 0 && midRatio < 0.25) {
+    else if (rules.match('1', {ge(aspectRatio, 0.65f, A), lt(aspectRatio, 0.75f, A), ge(density, 0.43f, D),
+                               lt(density, 0.55f, D), holesEq(numHoles, 0), lt(midRatio, 0.25f, R)})) {
         result = '1';
     }
     // 8: 两个孔洞,密度高 - 必须优先判断,避免被误判为除号
-    else if (numHoles >= 2 && density > 0.55 && aspectRatio > 0.6 && aspectRatio <= 0.85 && h >= 25) {
+    else if (rules.match('8', {holesGe(numHoles, 2), gt(density, 0.55f, D), gt(aspectRatio, 0.6f, A),
+                               le(aspectRatio, 0.85f, A), ge(h, 25, H)})) {
         result = '8';
     }
     // 除号: 合并后的整体(点-线-点结构),有2个孔(上下点),低密度
-    else if (numHoles >= 2 && h > 15 && h < 35 && density < 0.40 && aspectRatio > 0.8 && aspectRatio < 1.6) {
+    else if (rules.match('/', {holesGe(numHoles, 2), gt(h, 15, H), lt(h, 35, H), lt(density, 0.40f, D),
+                               gt(aspectRatio, 0.8f, A), lt(aspectRatio, 1.6f, A)})) {
         result = '/';
     }
     // 0: 一个孔洞,密度中等,上下相对均匀,中部不太重
-    else if (numHoles >= 1 && density > 0.48 && density < 0.60 && midRatio < 0.30) {
+    else if (rules.match('0', {holesGe(numHoles, 1), gt(density, 0.48f, D), lt(density, 0.60f, D),
+                               lt(midRatio, 0.30f, R)})) {
         result = '0';
     }
     // 9: 一个孔洞,底部最轻(9的关键特征: 上重下轻)
-    else if (numHoles >= 1 && density > 0.52 && botRatio < 0.32) {
+    else if (rules.match('9', {holesGe(numHoles, 1), gt(density, 0.52f, D), lt(botRatio, 0.32f, R)})) {
         result = '9';
     }
     // 6: 一个孔洞,底部不是最轻,且中部>=顶部
-    else if (numHoles >= 1 && density > 0.52 && midRatio >= topRatio) {
+    else if (rules.match('6', {holesGe(numHoles, 1), gt(density, 0.52f, D), ge(midRatio, topRatio, R)})) {
         result = '6';
     }
     // 4: 一个孔洞,密度较低,中部较重
-    else if (numHoles >= 1 && density < 0.60 && midRatio > 0.28) {
+    else if (rules.match('4', {holesGe(numHoles, 1), lt(density, 0.60f, D), gt(midRatio, 0.28f, R)})) {
         result = '4';
     }
     // 0 (兜底): 一个孔洞,其他情况
-    else if (numHoles >= 1 && density > 0.48) {
+    else if (rules.match('?', {holesGe(numHoles, 1), gt(density, 0.48f, D)})) {
         // 精细判断: 如果顶部明显>底部,可能是9
         if (topRatio > botRatio + 0.05 && botRatio < 0.35) {
             result = '9';
@@ -174,306 +385,418 @@ char FormulaRecognizer::recognizeCharacter(const Mat& roi, const Rect& box) {
         } else {
             result = '0';
         }
+        rules.limit(kFallbackConfidence);
     }
     // 2: 无孔洞,顶部和底部较重,中部明显较轻
-    else if (numHoles == 0 && topRatio > 0.30 && botRatio > 0.35 && midRatio < 0.28 && density > 0.45) {
+    else if (rules.match('2', {holesEq(numHoles, 0), gt(topRatio, 0.30f, R), gt(botRatio, 0.35f, R),
+                               lt(midRatio, 0.28f, R), gt(density, 0.45f, D)})) {
         result = '2';
     }
     // 7: 顶部非常重,中下轻,密度低
-    else if (numHoles == 0 && topRatio > 0.45 && midRatio < 0.28 && density < 0.45) {
+    else if (rules.match('7', {holesEq(numHoles, 0), gt(topRatio, 0.45f, R), lt(midRatio, 0.28f, R),
+                               lt(density, 0.45f, D)})) {
         result = '7';
     }
     // 3: 无孔洞,底部较重,中部较轻
-    else if (numHoles == 0 && density > 0.45 && botRatio > 0.35 && midRatio < 0.32) {
+    else if (rules.match('3', {holesEq(numHoles, 0), gt(density, 0.45f, D), gt(botRatio, 0.35f, R),
+                               lt(midRatio, 0.32f, R)})) {
         result = '3';
     }
     // 5: 无孔洞,中部相对较重,上中下较均匀
-    else if (numHoles == 0 && density > 0.47 && midRatio > 0.32 && topRatio > 0.28) {
+    else if (rules.match('5', {holesEq(numHoles, 0), gt(density, 0.47f, D), gt(midRatio, 0.32f, R),
+                               gt(topRatio, 0.28f, R)})) {
         result = '5';
     }
     // 兜底判断 - 无孔洞数字的最终分类
-    else if (numHoles == 0) {
+    else if (rules.match('?', {holesEq(numHoles, 0)})) {
         if (aspectRatio < 0.65 && density < 0.43) result = '1';
         else if (density < 0.48) result = '5';
         else if (midRatio < 0.25) result = '2';
         else result = '3';
+        rules.limit(kFallbackConfidence);
     }
 
+    confidence = rules.confidence(result);
     return result;
 }
 
-vector<RecognizedChar> FormulaRecognizer::detectCharacters(const Mat& binary) {
-    vector<RecognizedChar> characters;
+// 连通域统计表中的一项
+struct ComponentStat {
+    int label;
+    Rect box;
+    int area;
+    int cell;              // 所属列间隙区间
+};
 
-    vector<vector<Point>> contours;
-    findContours(binary.clone(), contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
+static bool isBar(const Rect& box) {
+    return box.height < 8 && box.width > box.height * 2.5;
+}
 
-    vector<Rect> boxes;
-    for (const auto& contour : contours) {
-        Rect box = boundingRect(contour);
-        if (box.width < 3 || box.height < 3 || box.area() < 15) {
-            continue;
-        }
-        boxes.push_back(box);
-    }
+static bool isDot(const Rect& box) {
+    return box.height < 8 && box.width < 8 && box.area() < 35;
+}
 
-    sort(boxes.begin(), boxes.end(),
-         [](const Rect& a, const Rect& b) { return a.x < b.x; });
+static bool isEqualsBar(const Rect& box) {
+    return box.height <= 10 && box.width > box.height * 3;
+}
 
-    // 合并等号的两条横线 和 除号(÷)的三个部分
-    vector<Rect> mergedBoxes;
+static void appendPart(Glyph& glyph, const ComponentStat& part) {
+    CV_Assert(glyph.numLabels < kMaxGlyphParts);
+    glyph.box = glyph.box | part.box;
+    glyph.area += part.area;
+    glyph.labels[glyph.numLabels++] = part.label;
+}
+
+static Glyph singleGlyph(const ComponentStat& comp) {
+    Glyph glyph;
+    glyph.box = comp.box;
+    glyph.area = comp.area;
+    glyph.labels[0] = comp.label;
+    glyph.numLabels = 1;
+    return glyph;
+}
+
+// 线性合并多部件符号: 等号的两条横线 和 除号(÷)的横线+上下点
+// comps 已按 x 排序, 每个连通域只与同一列区间内相邻的常数个连通域比较
+static vector<Glyph> mergeSymbolParts(const vector<ComponentStat>& comps) {
+    vector<Glyph> glyphs;
+    glyphs.reserve(comps.size());
+
+    // 上一个字形是否由单个点构成(除号的点可能排在横线之前)
+    int lastDotGlyph = -1;
     size_t i = 0;
-    while (i < boxes.size()) {
-        Rect box = boxes[i];
-
-        // 检测除号: 可能是 横线+上点+下点 或 上点+横线+下点 等顺序
-        // 先找横线
-        if (box.height < 8 && box.width > box.height * 2.5) {  // 横线
-            // 检查前后是否有小点
-            vector<size_t> dotIndices;
-            for (size_t j = (i > 0 ? i - 1 : 0); j < min(i + 3, boxes.size()); j++) {
-                if (j == i) continue;
-                Rect testBox = boxes[j];
-                if (testBox.height < 8 && testBox.width < 8 && testBox.area() < 35) {
-                    int xDiff = abs(testBox.x - box.x);
-                    int yDiff = abs(testBox.y - box.y);
-                    if (xDiff < 20 && yDiff > 2 && yDiff < 20) {
-                        dotIndices.push_back(j);
-                    }
+    while (i < comps.size()) {
+        const ComponentStat& comp = comps[i];
+
+        // 除号: 横线 + 前后相邻的两个小点(最多收集两个, 噪声点再多也不并入)
+        if (isBar(comp.box)) {
+            int dots[kMaxGlyphParts - 1];
+            int numDots = 0;
+            size_t lastUsed = i;
+
+            auto matchDot = [&](const ComponentStat& d) {
+                int xDiff = abs(d.box.x - comp.box.x);
+                int yDiff = abs(d.box.y - comp.box.y);
+                return d.cell == comp.cell && isDot(d.box) &&
+                       xDiff < 20 && yDiff > 2 && yDiff < 20;
+            };
+
+            if (i > 0 && lastDotGlyph == (int)glyphs.size() - 1 && lastDotGlyph >= 0 &&
+                matchDot(comps[i - 1])) {
+                dots[numDots++] = (int)i - 1;
+            }
+            size_t end = min(i + 3, comps.size());
+            for (size_t j = i + 1; j < end && numDots < kMaxGlyphParts - 1; j++) {
+                if (matchDot(comps[j])) {
+                    dots[numDots++] = (int)j;
+                    lastUsed = j;
                 }
             }
 
-            // 如果找到2个点,合并为除号
-            if (dotIndices.size() >= 2) {
-                vector<Rect> allBoxes = {box};
-                for (size_t idx : dotIndices) {
-                    allBoxes.push_back(boxes[idx]);
+            if (numDots >= 2) {
+                // 横线前的点已作为单独字形输出, 撤回后并入除号
+                if (dots[0] == (int)i - 1) {
+                    glyphs.pop_back();
                 }
-
-                int minX = box.x, minY = box.y, maxX = box.br().x, maxY = box.br().y;
-                for (const auto& b : allBoxes) {
-                    minX = min(minX, b.x);
-                    minY = min(minY, b.y);
-                    maxX = max(maxX, b.br().x);
-                    maxY = max(maxY, b.br().y);
+                Glyph glyph = singleGlyph(comp);
+                for (int k = 0; k < numDots; k++) {
+                    appendPart(glyph, comps[dots[k]]);
                 }
+                glyphs.push_back(glyph);
 
-                mergedBoxes.push_back(Rect(minX, minY, maxX - minX, maxY - minY));
-
-                // 跳过已处理的框
-                size_t maxIdx = *max_element(dotIndices.begin(), dotIndices.end());
-                i = maxIdx + 1;
+                // 横线与最后一个点之间未被合并的连通域仍单独输出
+                for (size_t j = i + 1; j < lastUsed; j++) {
+                    if (find(dots, dots + numDots, (int)j) == dots + numDots) {
+                        glyphs.push_back(singleGlyph(comps[j]));
+                    }
+                }
+                lastDotGlyph = -1;
+                i = lastUsed + 1;
                 continue;
             }
         }
 
-        // 合并等号的两条横线
-        if (box.height <= 10 && box.width > box.height * 3) {
-            if (i + 1 < boxes.size()) {
-                Rect nextBox = boxes[i + 1];
-                int xDiff = abs(box.x - nextBox.x);
-                int yDiff = abs(box.y - nextBox.y);
-
-                if (nextBox.height <= 10 && nextBox.width > nextBox.height * 3 &&
-                    xDiff < 10 && yDiff > 3 && yDiff < 20) {
-                    int minX = min(box.x, nextBox.x);
-                    int minY = min(box.y, nextBox.y);
-                    int maxX = max(box.br().x, nextBox.br().x);
-                    int maxY = max(box.br().y, nextBox.br().y);
-
-                    mergedBoxes.push_back(Rect(minX, minY, maxX - minX, maxY - minY));
-                    i += 2;
-                    continue;
-                }
+        // 等号: 两条上下排列的横线
+        if (isEqualsBar(comp.box) && i + 1 < comps.size()) {
+            const ComponentStat& next = comps[i + 1];
+            int xDiff = abs(comp.box.x - next.box.x);
+            int yDiff = abs(comp.box.y - next.box.y);
+
+            if (next.cell == comp.cell && isEqualsBar(next.box) &&
+                xDiff < 10 && yDiff > 3 && yDiff < 20) {
+                Glyph glyph = singleGlyph(comp);
+                appendPart(glyph, next);
+                glyphs.push_back(glyph);
+                lastDotGlyph = -1;
+                i += 2;
+                continue;
             }
         }
 
-        mergedBoxes.push_back(box);
+        glyphs.push_back(singleGlyph(comp));
+        lastDotGlyph = isDot(comp.box) ? (int)glyphs.size() - 1 : -1;
         i++;
     }
 
-    // 识别每个字符,直到遇到等号就停止
-    for (const auto& box : mergedBoxes) {
-        Mat roi = binary(box);
-        char recognized = recognizeCharacter(roi, box);
+    return glyphs;
+}
 
-        if (recognized != '?') {
-            characters.push_back(RecognizedChar(recognized, box));
+vector<Glyph> FormulaRecognizer::segmentGlyphs(const Mat& binary, Mat& labels) const {
+    // 整行一次连通域标记, 同时得到外接矩形、面积和质心
+    Mat stats, centroids;
+    int numLabels = connectedComponentsWithStats(binary, labels, stats, centroids, 8, CV_32S);
+
+    // 列间隙预分割: 垂直投影中被空白列隔开的区间互不相连,
+    // 多部件符号(=、÷)的各部分在水平方向重叠, 只在同一区间内合并
+    vector<Range> cells = projectionRuns(verticalProjection(binary));
+    vector<int> columnCell(binary.cols, -1);
+    for (int c = 0; c < (int)cells.size(); c++) {
+        for (int x = cells[c].start; x < cells[c].end; x++) {
+            columnCell[x] = c;
+        }
+    }
 
-            // 遇到等号就停止识别后续字符
-            if (recognized == '=') {
-                break;
-            }
+    vector<ComponentStat> comps;
+    comps.reserve(numLabels);
+    for (int label = 1; label < numLabels; label++) {  // 0 为背景
+        const int* st = stats.ptr<int>(label);
+        Rect box(st[CC_STAT_LEFT], st[CC_STAT_TOP], st[CC_STAT_WIDTH], st[CC_STAT_HEIGHT]);
+        if (box.width < 3 || box.height < 3 || box.area() < 15) {
+            continue;
         }
+        ComponentStat comp;
+        comp.label = label;
+        comp.box = box;
+        comp.area = st[CC_STAT_AREA];
+        comp.cell = columnCell[box.x];
+        comps.push_back(comp);
     }
 
-    return characters;
-}
+    sort(comps.begin(), comps.end(),
+         [](const ComponentStat& a, const ComponentStat& b) { return a.box.x < b.box.x; });
 
-double FormulaRecognizer::evaluateExpression(const string& expr) {
-    string expression = expr;
+    return mergeSymbolParts(comps);
+}
 
-    if (!expression.empty() && expression.back() == '=') {
-        expression.pop_back();
+char FormulaRecognizer::classifyGlyph(const Mat& labels, const Glyph& glyph, float& confidence) const {
+    // 像素完全相同的字形直接复用分类结果(与重新分类一致)
+    GlyphKey key;
+    if (glyphCache) {
+        extractGlyphKey(labels, glyph, key);
+        char cached;
+        if (glyphCache->lookup(key, cached, confidence)) {
+            return cached;
+        }
     }
 
-    for (size_t i = 0; i < expression.length(); i++) {
-        if (expression[i] == 'x') expression[i] = '*';
+    // 特征直接在标签图上单次遍历得到, 不再为每个字形生成掩码、缩放或提取轮廓
+    GlyphFeatures features;
+    extractGlyphFeatures(labels, glyph, features);
+    char recognized = recognizeCharacter(features, confidence);
+
+    // 规则裕量不足的少数字形交给字形库做最近邻模板匹配
+    if (confidence < kLowConfidence && !glyphBank.empty()) {
+        GlyphTemplate tmpl;
+        extractGlyphTemplate(labels, glyph, tmpl);
+        float matchConfidence = 0.0f;
+        char matched = glyphBank.classify(tmpl, matchConfidence);
+        if (matched != '?' && (recognized == '?' || matchConfidence > confidence)) {
+            recognized = matched;
+            confidence = matchConfidence;
+        }
     }
 
-    // 使用双栈算法实现运算符优先级(支持括号)
-    try {
-        stack<double> numbers;
-        stack<char> operators;
-
-        // 运算符优先级判断
-        auto precedence = [](char op) -> int {
-            if (op == '(') return 0;  // 括号优先级最低
-            if (op == '+' || op == '-') return 1;
-            if (op == '*' || op == '/') return 2;
-            return 0;
-        };
-
-        // 执行运算
-        auto applyOp = [](double a, double b, char op) -> double {
-            switch (op) {
-                case '+': return a + b;
-                case '-': return a - b;
-                case '*': return a * b;
-                case '/': return (b != 0) ? a / b : 0;
-                default: return 0;
-            }
-        };
-
-        size_t i = 0;
-        while (i < expression.length()) {
-            if (expression[i] == ' ') {
-                i++;
-                continue;
-            }
-
-            if (expression[i] == 's') {
-                i++;
-                double num = 0;
-                while (i < expression.length() && isdigit(expression[i])) {
-                    num = num * 10 + (expression[i] - '0');
-                    i++;
-                }
-                numbers.push(sqrt(num));
-            }
-            else if (expression[i] == '(') {
-                operators.push('(');
-                i++;
-            }
-            else if (expression[i] == ')') {
-                while (!operators.empty() && operators.top() != '(') {
-                    if (numbers.size() < 2) return 0.0;
-
-                    char op = operators.top();
-                    operators.pop();
-
-                    double b = numbers.top(); numbers.pop();
-                    double a = numbers.top(); numbers.pop();
-
-                    numbers.push(applyOp(a, b, op));
-                }
+    if (glyphCache) {
+        glyphCache->insert(key, recognized, confidence);
+    }
 
-                if (!operators.empty() && operators.top() == '(') {
-                    operators.pop();
-                }
-                i++;
-            }
-            else if (isdigit(expression[i])) {
-                double num = 0;
-                while (i < expression.length() && isdigit(expression[i])) {
-                    num = num * 10 + (expression[i] - '0');
-                    i++;
-                }
-                numbers.push(num);
-            }
-            else if (expression[i] == '+' || expression[i] == '-' ||
-                     expression[i] == '*' || expression[i] == '/') {
-                char op = expression[i];
+    return recognized;
+}
 
-                while (!operators.empty() && operators.top() != '(' &&
-                       precedence(operators.top()) >= precedence(op)) {
-                    if (numbers.size() < 2) return 0.0;
+vector<RecognizedChar> FormulaRecognizer::detectCharacters(const Mat& binary,
+                                                           RecognitionProfile* profile) const {
+    vector<RecognizedChar> characters;
 
-                    char topOp = operators.top();
-                    operators.pop();
+    Mat labels;
+    vector<Glyph> glyphs;
+    {
+        StageTimer timer(profile, STAGE_SEGMENTATION);
+        glyphs = segmentGlyphs(binary, labels);
+    }
 
-                    double b = numbers.top(); numbers.pop();
-                    double a = numbers.top(); numbers.pop();
+    // 识别每个字符,直到遇到等号就停止
+    StageTimer timer(profile, STAGE_CLASSIFICATION);
+    for (const auto& glyph : glyphs) {
+        float confidence = 0.0f;
+        char recognized = classifyGlyph(labels, glyph, confidence);
 
-                    numbers.push(applyOp(a, b, topOp));
-                }
+        if (recognized != '?') {
+            characters.push_back(RecognizedChar(recognized, glyph.box, confidence));
 
-                operators.push(op);
-                i++;
-            }
-            else {
-                i++;
+            // 遇到等号就停止识别后续字符
+            if (recognized == '=') {
+                break;
             }
         }
+    }
 
-        while (!operators.empty()) {
-            if (numbers.size() < 2) return 0.0;
-
-            char op = operators.top();
-            operators.pop();
-
-            if (op == '(') continue;  // 忽略未匹配的左括号
+    return characters;
+}
 
-            double b = numbers.top(); numbers.pop();
-            double a = numbers.top(); numbers.pop();
+// 表达式编译为定长 RPN 程序后求值, 不分配堆内存; 失败时返回错误码, value 为 NaN
+ExprError FormulaRecognizer::evaluateExpression(const string& expr, double& value,
+                                                int& errorPos) const {
+    ExpressionProgram program;
+    program.compile(expr);
+    errorPos = program.errorPosition();
+    return program.evaluate(value);
+}
 
-            numbers.push(applyOp(a, b, op));
-        }
+// ============================================================================
+// 分辨率归一化: 规则中的像素阈值(h>35、h<=10、点<8、面积<15 等)按约 40px 的字形高度标定
+// ============================================================================
 
-        if (!numbers.empty()) {
-            return numbers.top();
+// 标定字形高度(内置测试图片的数字高度约 30px 与 52px)
+static const int kCanonicalGlyphHeight = 40;
+// 中位字形高度超过标定高度的该倍数时才缩小, 常规分辨率的行保持原样
+static const double kNormalizeRatio = 1.5;
+
+// 行内字形高度中位数: 垂直投影切分列区间, 每个区间的墨迹上下边界之差
+static int estimateGlyphHeight(const Mat& rowBinary) {
+    vector<Range> cells = projectionRuns(verticalProjection(rowBinary));
+    vector<int> heights;
+    heights.reserve(cells.size());
+    for (const auto& cell : cells) {
+        Rect region(cell.start, 0, cell.size(), rowBinary.rows);
+        vector<Range> ink = projectionRuns(horizontalProjection(rowBinary, region));
+        if (!ink.empty()) {
+            heights.push_back(ink.back().end - ink.front().start);
         }
-    } catch (...) {
-        return 0.0;
     }
+    if (heights.empty()) return 0;
 
-    return 0.0;
+    nth_element(heights.begin(), heights.begin() + heights.size() / 2, heights.end());
+    return heights[heights.size() / 2];
 }
 
-pair<string, double> FormulaRecognizer::recognizeFormula(const Mat& image) {
-    cout << "开始图像预处理..." << endl;
+// 缩小后的框映射回原始行坐标(向外取整, 不超出行范围)
+static Rect scaleBoxBack(const Rect& box, double scale, const Size& rowSize) {
+    int x0 = (int)floor(box.x / scale);
+    int y0 = (int)floor(box.y / scale);
+    int x1 = min(rowSize.width, (int)ceil((box.x + box.width) / scale));
+    int y1 = min(rowSize.height, (int)ceil((box.y + box.height) / scale));
+    return Rect(x0, y0, x1 - x0, y1 - y0);
+}
 
-    Mat binary = preprocessImage(image);
+// 在已二值化的图像上识别一个公式行: 字符分割、表达式与等号位置均来自同一次分割
+// 过程信息写入 log, 并发识别多行时由调用方按行序统一输出
+FormulaResult FormulaRecognizer::recognizeRow(const Mat& binary, const Rect& row,
+                                              ostream& log, RecognitionProfile* profile) const {
+    FormulaResult formulaResult;
+    formulaResult.result = 0.0;
+    formulaResult.boundingBox = row;
+    formulaResult.equalsSignBox = Rect(row.x, row.y, 0, 0);
+
+    // 高分辨率行先缩小到标定字形高度再分割识别: 单行耗时与扫描 DPI 无关, 规则阈值保持有效
+    Mat rowBinary = binary(row);
+    int glyphHeight = estimateGlyphHeight(rowBinary);
+    double scale = 1.0;
+    if (glyphHeight > kCanonicalGlyphHeight * kNormalizeRatio) {
+        StageTimer timer(profile, STAGE_PREPROCESS);
+        scale = (double)kCanonicalGlyphHeight / glyphHeight;
+        Mat resized;
+        resize(rowBinary, resized, Size(), scale, scale, INTER_AREA);
+        threshold(resized, rowBinary, 127, 255, THRESH_BINARY);
+        if (logEnabled(LOG_INFO)) {
+            log << "分辨率归一化: 字形高度 " << glyphHeight << "px -> " << kCanonicalGlyphHeight
+                << "px (缩放 " << (int)(scale * 100 + 0.5) << "%)\n";
+        }
+    }
 
-    cout << "正在检测字符..." << endl;
-    vector<RecognizedChar> chars = detectCharacters(binary);
+    vector<RecognizedChar> chars = detectCharacters(rowBinary, profile);
+    if (scale != 1.0) {
+        for (auto& ch : chars) {
+            ch.boundingBox = scaleBoxBack(ch.boundingBox, scale, row.size());
+        }
+    }
 
     if (chars.empty()) {
-        cout << "警告: 未检测到任何字符!" << endl;
-        return make_pair("", 0.0);
+        if (logEnabled(LOG_WARN)) log << "警告: 未检测到任何字符!\n";
+        return formulaResult;
     }
 
-    cout << "检测到 " << chars.size() << " 个字符" << endl;
+    if (logEnabled(LOG_INFO)) log << "检测到 " << chars.size() << " 个字符\n";
 
-    string expression;
     for (const auto& ch : chars) {
-        expression += ch.character;
+        // 字符框转换到图片坐标
+        Rect box(ch.boundingBox.x + row.x, ch.boundingBox.y + row.y,
+                 ch.boundingBox.width, ch.boundingBox.height);
+        formulaResult.characters.push_back(RecognizedChar(ch.character, box, ch.confidence));
+        formulaResult.expression += ch.character;
         if (ch.character == '=') {
-            equalsSignBox = ch.boundingBox;
+            formulaResult.equalsSignBox = box;
         }
     }
 
-    cout << "识别的字符序列: " << expression << endl;
+    if (logEnabled(LOG_INFO)) log << "识别的字符序列: " << formulaResult.expression << "\n";
+
+    StageTimer timer(profile, STAGE_EVALUATION);
+    int errorPos = -1;
+    ExprError error = evaluateExpression(formulaResult.expression, formulaResult.result, errorPos);
+    if (error != EXPR_OK) {
+        // 只有失败时才生成错误描述
+        formulaResult.error = exprErrorMessage(error);
+        if (errorPos >= 0) {
+            formulaResult.error = "第 " + to_string(errorPos + 1) + " 个字符处" + formulaResult.error;
+        }
+        if (logEnabled(LOG_WARN)) log << "警告: 表达式无法计算: " << formulaResult.error << "\n";
+    }
 
-    double result = evaluateExpression(expression);
+    return formulaResult;
+}
+
+FormulaResult FormulaRecognizer::recognizeFormula(const Mat& image,
+                                                  RecognitionProfile* profile) const {
+    // 日志先缓冲, 整张图片识别完成后一次写出, 并发调用时不在控制台上互相等待
+    ostringstream log;
+    if (logEnabled(LOG_INFO)) log << "开始图像预处理...\n";
+
+    Mat binary;
+    {
+        StageTimer timer(profile, STAGE_PREPROCESS);
+        binary = preprocessImage(image);
+    }
+
+    if (logEnabled(LOG_INFO)) log << "正在检测字符...\n";
+    FormulaResult result = recognizeRow(binary, Rect(0, 0, binary.cols, binary.rows), log, profile);
+    if (profile) profile->images++;
+
+    if (logEnabled(LOG_WARN)) cout << log.str();
+    return result;
+}
 
-    return make_pair(expression, result);
+// 标注文字: 整数不带小数, 其余保留 2 位; 表达式无法计算时为 "?"
+static string formatResult(const FormulaResult& formulaResult) {
+    if (!formulaResult.error.empty()) {
+        return "?";
+    }
+    stringstream ss;
+    if (formulaResult.result == floor(formulaResult.result)) {
+        ss << static_cast<int>(formulaResult.result);
+    } else {
+        ss << fixed << setprecision(2) << formulaResult.result;
+    }
+    return ss.str();
 }
 
-void FormulaRecognizer::writeResultToImage(const Mat& image, const string& formula,
-                                          double result, const string& outputPath) {
+void FormulaRecognizer::writeResultToImage(const Mat& image, const FormulaResult& formulaResult,
+                                          const string& outputPath,
+                                          RecognitionProfile* profile) const {
+    StageTimer timer(profile, STAGE_RENDERING);
     Mat outputImage = image.clone();
 
+    const Rect& equalsSignBox = formulaResult.equalsSignBox;
+
     int textX, textY;
     if (equalsSignBox.width > 0) {
         textX = equalsSignBox.x + equalsSignBox.width + 10;
@@ -483,13 +806,7 @@ void FormulaRecognizer::writeResultToImage(const Mat& image, const string& formu
         textY = image.rows / 2;
     }
 
-    stringstream ss;
-    if (result == floor(result)) {
-        ss << static_cast<int>(result);
-    } else {
-        ss << fixed << setprecision(2) << result;
-    }
-    string resultText = ss.str();
+    string resultText = formatResult(formulaResult);
 
     int fontFace = FONT_HERSHEY_SIMPLEX;
     double fontScale = 1.5;
@@ -523,109 +840,304 @@ void FormulaRecognizer::writeResultToImage(const Mat& image, const string& formu
 }
 
 // 检测多个公式行
-vector<Rect> FormulaRecognizer::detectFormulaRows(const Mat& binary) {
-    vector<Rect> rowRects;
+vector<Rect> FormulaRecognizer::detectFormulaRows(const Mat& binary) const {
+    // 递归 XY-cut: 单栏页面即按空白行切出的公式行, 多栏工作表再按栏间空白切开,
+    // 每个区域是一个独立的公式, 可并发识别
+    return xyCutRegions(binary);
+}
 
-    vector<int> horizontalProjection(binary.rows, 0);
-    for (int y = 0; y < binary.rows; y++) {
-        for (int x = 0; x < binary.cols; x++) {
-            if (binary.at<uchar>(y, x) == 255) {
-                horizontalProjection[y]++;
-            }
-        }
+vector<FormulaResult> FormulaRecognizer::recognizeMultipleFormulas(const Mat& image,
+                                                                  RecognitionProfile* profile) const {
+    vector<FormulaResult> results;
+    ostringstream log;
+
+    if (logEnabled(LOG_INFO)) log << "开始多公式识别...\n";
+
+    // 整页只二值化一次, 行检测与各行字符分割共用同一张二值图
+    Mat binary;
+    {
+        StageTimer timer(profile, STAGE_PREPROCESS);
+        binary = preprocessImage(image);
     }
 
-    bool inFormula = false;
-    int startY = 0;
+    vector<Rect> formulaRows;
+    {
+        StageTimer timer(profile, STAGE_ROW_DETECTION);
+        formulaRows = detectFormulaRows(binary);
+    }
+    if (profile) profile->images++;
 
-    for (int y = 0; y < binary.rows; y++) {
-        if (horizontalProjection[y] > 0) {
-            if (!inFormula) {
-                startY = y;
-                inFormula = true;
-            }
-        } else {
-            if (inFormula) {
-                int endY = y - 1;
-                if (endY - startY > 10) {
-                    rowRects.push_back(Rect(0, startY, binary.cols, endY - startY + 1));
-                }
-                inFormula = false;
-            }
+    if (formulaRows.empty()) {
+        if (logEnabled(LOG_WARN)) cout << log.str() << "警告: 未检测到任何公式行!\n";
+        return results;
+    }
+
+    if (logEnabled(LOG_INFO)) log << "检测到 " << formulaRows.size() << " 个公式行\n";
+
+    // 各行相互独立, 并发识别; 结果、日志与阶段耗时按行收集, 全部完成后统一输出/合并
+    results.resize(formulaRows.size());
+    vector<string> rowLogs(formulaRows.size());
+    vector<RecognitionProfile> rowProfiles(profile ? formulaRows.size() : 0);
+
+    parallel_for_(Range(0, (int)formulaRows.size()), [&](const Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            ostringstream rowLog;
+            if (logEnabled(LOG_INFO)) rowLog << "\n--- 识别第 " << (i + 1) << " 个公式 ---\n";
+
+            results[i] = recognizeRow(binary, formulaRows[i], rowLog,
+                                      profile ? &rowProfiles[i] : nullptr);
+
+            if (logEnabled(LOG_INFO)) rowLog << "计算结果: " << results[i].result << "\n";
+            rowLogs[i] = rowLog.str();
         }
+    });
+
+    for (const auto& rowProfile : rowProfiles) {
+        profile->merge(rowProfile);
     }
 
-    if (inFormula) {
-        int endY = binary.rows - 1;
-        if (endY - startY > 10) {
-            rowRects.push_back(Rect(0, startY, binary.cols, endY - startY + 1));
+    if (logEnabled(LOG_WARN)) {
+        for (const auto& rowLog : rowLogs) {
+            log << rowLog;
         }
+        cout << log.str();
     }
 
-    return rowRects;
+    return results;
 }
 
-vector<FormulaResult> FormulaRecognizer::recognizeMultipleFormulas(const Mat& image) {
-    vector<FormulaResult> results;
+// 行内结果平移到页面坐标
+static void offsetResult(FormulaResult& result, int dx, int dy) {
+    result.boundingBox.x += dx;
+    result.boundingBox.y += dy;
+    result.equalsSignBox.x += dx;
+    result.equalsSignBox.y += dy;
+    for (auto& ch : result.characters) {
+        ch.boundingBox.x += dx;
+        ch.boundingBox.y += dy;
+    }
+}
 
-    cout << "开始多公式识别..." << endl;
+int FormulaRecognizer::recognizeBanded(BandSource& source, int bandRows,
+                                       const function<void(const FormulaResult&)>& onRow) const {
+    // 闭运算(2×2 核)的结果行只依赖其上方 2 行, 条带前接上一条带最后 2 行阈值图即与整页处理逐像素一致
+    const int kCloseHalo = 2;
 
-    Mat binary = preprocessImage(image);
+    vector<int> hist;
+    if (!source.histogram(hist)) {
+        return 0;
+    }
+    double thresh = otsuThreshold(hist);
+    Mat kernel = getStructuringElement(MORPH_RECT, Size(2, 2));
 
-    vector<Rect> formulaRows = detectFormulaRows(binary);
+    int emitted = 0;
+    int pageY = 0;        // 当前条带首行的页面坐标
+    int runStart = -1;    // 未闭合公式行的起始行, -1 表示不在行内
+    Mat halo;             // 上一条带末尾的阈值图(闭运算前)
+    Mat rowBuffer;        // 未闭合公式行的二值图, 最多为最高公式行的高度
+
+    // 公式行闭合: 与 detectFormulaRows 相同的高度规则, 识别后立即回调并释放缓冲
+    auto closeRow = [&](int endY) {
+        if (endY - 1 - runStart > 10) {
+            // 多栏页面: 闭合的行带内再做 XY-cut, 各栏中的公式分别识别
+            for (const Rect& region : xyCutRegions(rowBuffer)) {
+                ostringstream log;
+                FormulaResult result = recognizeRow(rowBuffer, region, log, nullptr);
+                offsetResult(result, 0, runStart);
+                if (logEnabled(LOG_WARN)) cout << log.str();
+                onRow(result);
+                emitted++;
+            }
+        }
+        rowBuffer.release();
+        runStart = -1;
+    };
 
-    if (formulaRows.empty()) {
-        cout << "警告: 未检测到任何公式行!" << endl;
-        return results;
+    Mat gray, thresholded, stacked, closed;
+    while (source.nextBand(bandRows, gray)) {
+        threshold(gray, thresholded, thresh, 255, THRESH_BINARY_INV);
+
+        if (halo.empty()) {
+            stacked = thresholded;
+        } else {
+            vconcat(halo, thresholded, stacked);
+        }
+        morphologyEx(stacked, closed, MORPH_CLOSE, kernel);
+        Mat band = closed.rowRange(halo.rows, closed.rows);
+        halo = stacked.rowRange(max(0, stacked.rows - kCloseHalo), stacked.rows).clone();
+
+        for (int r = 0; r < band.rows; r++) {
+            Mat line = band.row(r);
+            if (countNonZero(line) > 0) {
+                if (runStart < 0) runStart = pageY + r;
+                rowBuffer.push_back(line);
+            } else if (runStart >= 0) {
+                closeRow(pageY + r);
+            }
+        }
+        pageY += band.rows;
     }
 
-    cout << "检测到 " << formulaRows.size() << " 个公式行" << endl;
+    if (runStart >= 0) {
+        closeRow(pageY);
+    }
 
-    for (size_t i = 0; i < formulaRows.size(); i++) {
-        cout << "\n--- 识别第 " << (i + 1) << " 个公式 ---" << endl;
+    return emitted;
+}
 
-        Rect row = formulaRows[i];
+// ============================================================================
+// 视频流增量识别
+// ============================================================================
 
-        Mat rowImage = image(row);
+// 缩略图边长缩小倍数与静止判定阈值(灰度级): 传感器噪声通常在阈值以内
+static const int kThumbnailFactor = 8;
+static const double kStillThreshold = 12.0;
+// 区域内容变化容差: 差异像素不超过参照墨迹的 2%(至少 3 个)视为未变化
+static const double kRowChangeRatio = 0.02;
+static const int kRowChangeMinPixels = 3;
+// 区域尺寸变化容差(像素)
+static const int kRowSizeTolerance = 2;
+
+StreamState::StreamState()
+    : frames(0), stillFrames(0), recognizedRows(0), reusedRows(0) {}
+
+// 二值图内容哈希(FNV-1a, 含尺寸), 与区域在帧中的位置无关
+static uint64_t binaryHash(const Mat& binary) {
+    uint64_t h = 1469598103934665603ULL;
+    auto mix = [&h](uint64_t v) {
+        h ^= v;
+        h *= 1099511628211ULL;
+    };
+    mix((uint64_t)binary.cols << 32 | (uint64_t)binary.rows);
+    for (int y = 0; y < binary.rows; y++) {
+        const uchar* row = binary.ptr<uchar>(y);
+        for (int x = 0; x < binary.cols; x++) {
+            mix(row[x]);
+        }
+    }
+    return h;
+}
 
-        auto result_pair = recognizeFormula(rowImage);
-        string expression = result_pair.first;
-        double result = result_pair.second;
+// 当前区域与参照区域的差异像素数(左上角对齐, 尺寸差部分全部计入)
+static int binaryDifference(const Mat& a, const Mat& b) {
+    int w = min(a.cols, b.cols);
+    int h = min(a.rows, b.rows);
+    Mat diff;
+    bitwise_xor(a(Rect(0, 0, w, h)), b(Rect(0, 0, w, h)), diff);
+    int outside = (int)(a.total() + b.total()) - 2 * w * h;
+    return countNonZero(diff) + outside;
+}
 
-        cout << "识别的字符序列: " << expression << endl;
-        cout << "计算结果: " << result << endl;
+// 两个区域的交并比
+static double overlapRatio(const Rect& a, const Rect& b) {
+    int inter = (a & b).area();
+    int uni = a.area() + b.area() - inter;
+    return uni > 0 ? (double)inter / uni : 0.0;
+}
 
-        Mat rowBinary = preprocessImage(rowImage);
-        vector<RecognizedChar> chars = detectCharacters(rowBinary);
+bool FormulaRecognizer::recognizeStreamFrame(const Mat& frame, StreamState& state) const {
+    state.frames++;
 
-        Rect localEqualsBox;
-        for (const auto& ch : chars) {
-            if (ch.character == '=') {
-                localEqualsBox = ch.boundingBox;
-                break;
+    Mat gray;
+    if (frame.channels() == 3) {
+        cvtColor(frame, gray, COLOR_BGR2GRAY);
+    } else {
+        gray = frame;
+    }
+
+    // 整帧静止: 与上一处理帧的缩略图逐像素差异都在噪声范围内, 连二值化也跳过
+    Mat thumbnail;
+    resize(gray, thumbnail, Size(max(1, gray.cols / kThumbnailFactor),
+                                 max(1, gray.rows / kThumbnailFactor)), 0, 0, INTER_AREA);
+    if (state.thumbnail.size() == thumbnail.size()) {
+        Mat diff;
+        absdiff(thumbnail, state.thumbnail, diff);
+        double maxDiff = 0.0;
+        minMaxLoc(diff, nullptr, &maxDiff);
+        if (maxDiff <= kStillThreshold) {
+            state.stillFrames++;
+            return false;
+        }
+    }
+    state.thumbnail = thumbnail;
+
+    Mat binary = preprocessImage(gray);
+    vector<Rect> regions = detectFormulaRows(binary);
+
+    // 每个区域先按内容哈希找完全相同的旧区域, 再找位置重叠、尺寸相近且差异像素很少的旧区域
+    vector<StreamRow> rows(regions.size());
+    vector<bool> used(state.rows.size(), false);
+    vector<int> pending;
+
+    for (size_t i = 0; i < regions.size(); i++) {
+        StreamRow& row = rows[i];
+        row.box = regions[i];
+        Mat current = binary(regions[i]);
+        uint64_t hash = binaryHash(current);
+
+        int match = -1;
+        for (size_t j = 0; j < state.rows.size() && match < 0; j++) {
+            if (!used[j] && state.rows[j].hash == hash &&
+                state.rows[j].binary.size() == current.size()) {
+                match = (int)j;
+            }
+        }
+        for (size_t j = 0; j < state.rows.size() && match < 0; j++) {
+            const StreamRow& old = state.rows[j];
+            if (used[j] || abs(old.box.width - row.box.width) > kRowSizeTolerance ||
+                abs(old.box.height - row.box.height) > kRowSizeTolerance ||
+                overlapRatio(old.box, row.box) < 0.5) {
+                continue;
+            }
+            int tolerance = max(kRowChangeMinPixels,
+                                (int)(countNonZero(old.binary) * kRowChangeRatio));
+            if (binaryDifference(current, old.binary) <= tolerance) {
+                match = (int)j;
             }
         }
 
-        FormulaResult formulaResult;
-        formulaResult.expression = expression;
-        formulaResult.result = result;
-        formulaResult.boundingBox = row;
-        formulaResult.equalsSignBox = Rect(
-            localEqualsBox.x + row.x,
-            localEqualsBox.y + row.y,
-            localEqualsBox.width,
-            localEqualsBox.height
-        );
-
-        results.push_back(formulaResult);
+        if (match >= 0) {
+            // 参照二值图保持为最近一次识别时的内容, 缓慢累积的变化最终也会触发重新识别
+            const StreamRow& old = state.rows[match];
+            used[match] = true;
+            row.binary = old.binary;
+            row.hash = old.hash;
+            row.result = old.result;
+            offsetResult(row.result, row.box.x - old.box.x, row.box.y - old.box.y);
+            state.reusedRows++;
+        } else {
+            row.binary = current.clone();
+            row.hash = hash;
+            pending.push_back((int)i);
+        }
     }
 
-    return results;
+    // 变化的区域并发识别
+    parallel_for_(Range(0, (int)pending.size()), [&](const Range& range) {
+        for (int k = range.start; k < range.end; k++) {
+            StreamRow& row = rows[pending[k]];
+            ostringstream log;
+            row.result = recognizeRow(binary, row.box, log, nullptr);
+        }
+    });
+    state.recognizedRows += pending.size();
+
+    bool changed = rows.size() != state.rows.size();
+    for (size_t i = 0; i < rows.size() && !changed; i++) {
+        const FormulaResult& a = rows[i].result;
+        const FormulaResult& b = state.rows[i].result;
+        changed = a.expression != b.expression || a.error != b.error ||
+                  (a.error.empty() && a.result != b.result);
+    }
+    state.rows.swap(rows);
+    return changed;
 }
 
 void FormulaRecognizer::writeMultipleResultsToImage(const Mat& image,
                                                    const vector<FormulaResult>& results,
-                                                   const string& outputPath) {
+                                                   const string& outputPath,
+                                                   RecognitionProfile* profile) const {
+    StageTimer timer(profile, STAGE_RENDERING);
     Mat outputImage = image.clone();
 
     int fontFace = FONT_HERSHEY_SIMPLEX;
@@ -634,13 +1146,7 @@ void FormulaRecognizer::writeMultipleResultsToImage(const Mat& image,
     Scalar textColor(0, 0, 255);
 
     for (const auto& formulaResult : results) {
-        stringstream ss;
-        if (formulaResult.result == floor(formulaResult.result)) {
-            ss << static_cast<int>(formulaResult.result);
-        } else {
-            ss << fixed << setprecision(2) << formulaResult.result;
-        }
-        string resultText = ss.str();
+        string resultText = formatResult(formulaResult);
 
         int textX = formulaResult.equalsSignBox.x + formulaResult.equalsSignBox.width + 10;
         int textY = formulaResult.equalsSignBox.y + formulaResult.equalsSignBox.height;
@@ -671,5 +1177,5 @@ void FormulaRecognizer::writeMultipleResultsToImage(const Mat& image,
 
     imwrite(outputPath, outputImage);
 
-    cout << "所有结果已写入图片: " << outputPath << endl;
+    if (logEnabled(LOG_INFO)) cout << "所有结果已写入图片: " << outputPath << "\n";
 }
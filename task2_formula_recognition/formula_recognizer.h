@@ -7,6 +7,15 @@
 #define FORMULA_RECOGNIZER_H
 
 #include <opencv2/opencv.hpp>
+#include "glyph_features.h"
+#include "glyph_bank.h"
+#include "glyph_cache.h"
+#include "band_source.h"
+#include "recognition_profile.h"
+#include "expression_program.h"
+#include <functional>
+#include <memory>
+#include <ostream>
 #include <string>
 #include <vector>
 #include <utility>
@@ -14,6 +23,13 @@
 using namespace cv;
 using namespace std;
 
+// 日志级别: 识别过程信息整张图片缓冲后一次写出到标准输出
+enum LogLevel {
+    LOG_SILENT = 0,        // 不输出
+    LOG_WARN,              // 只输出警告(未检测到字符/公式行)
+    LOG_INFO               // 输出识别过程(默认)
+};
+
 // 识别的字符结构体
 struct RecognizedChar {
     char character;
@@ -29,32 +45,90 @@ struct FormulaResult {
     string expression;      // 识别的公式表达式
     double result;          // 计算结果
     Rect boundingBox;       // 公式在图片中的位置
-    Rect equalsSignBox;     // 等号的位置
+    Rect equalsSignBox;     // 等号的位置(未识别到等号时宽度为0)
+    vector<RecognizedChar> characters;  // 识别的字符(图片坐标)及置信度
+    string error;           // 表达式无法解析或计算时的错误描述(此时 result 为 NaN), 成功时为空
+};
+
+// 视频流中的一个公式区域: 最近一次识别时的区域二值图与结果
+struct StreamRow {
+    Rect box;              // 当前帧中的位置
+    Mat binary;            // 最近一次识别时的区域二值图(变化检测的参照)
+    uint64_t hash;         // binary 的内容哈希
+    FormulaResult result;  // 识别结果(已平移到当前帧坐标)
 };
 
+// 视频流增量识别状态(每路视频一个, 由调用方持有)
+struct StreamState {
+    vector<StreamRow> rows;     // 上一处理帧的公式区域(版面顺序)
+    Mat thumbnail;              // 上一处理帧的缩略灰度图, 整帧静止时跳过二值化
+    uint64_t frames;            // 送入的帧数
+    uint64_t stillFrames;       // 整帧静止而跳过的帧数
+    uint64_t recognizedRows;    // 重新识别的区域数
+    uint64_t reusedRows;        // 复用上次结果的区域数
+
+    StreamState();
+};
 
 // 公式识别器类
+// 识别接口均为 const 且不保存调用间状态, 同一实例可被多个线程并发调用
 class FormulaRecognizer {
 private:
-    Rect equalsSignBox;  // 保存等号的位置
+    LogLevel logLevel;  // 识别过程信息的输出级别(批量/并发场景应关闭)
+    GlyphBank glyphBank;  // 低置信度字形的第二级分类器(为空时只用规则)
+    shared_ptr<GlyphCache> glyphCache;  // 字形分类结果缓存(内部加锁, 为空时不缓存)
+    uint64_t glyphBankHash;  // 已加载标注文件字节与字形模板数据的哈希, 参与配置指纹
 
     // 私有方法
-    Mat preprocessImage(const Mat& input);
-    char recognizeCharacter(const Mat& roi, const Rect& box);
-    vector<RecognizedChar> detectCharacters(const Mat& binary);
-    double evaluateExpression(const string& expr);
-    vector<Rect> detectFormulaRows(const Mat& binary);
+    Mat preprocessImage(const Mat& input) const;
+    char recognizeCharacter(const GlyphFeatures& features, float& confidence) const;
+    char classifyGlyph(const Mat& labels, const Glyph& glyph, float& confidence) const;
+    vector<Glyph> segmentGlyphs(const Mat& binary, Mat& labels) const;
+    bool logEnabled(LogLevel level) const { return level <= logLevel; }
+    vector<RecognizedChar> detectCharacters(const Mat& binary, RecognitionProfile* profile) const;
+    ExprError evaluateExpression(const string& expr, double& value, int& errorPos) const;
+    vector<Rect> detectFormulaRows(const Mat& binary) const;
+    FormulaResult recognizeRow(const Mat& binary, const Rect& row, ostream& log,
+                               RecognitionProfile* profile) const;
 
 public:
     FormulaRecognizer();
-    pair<string, double> recognizeFormula(const Mat& image);
-    vector<FormulaResult> recognizeMultipleFormulas(const Mat& image);
+    void setLogLevel(LogLevel level);  // 需在并发调用前设置
+    void setVerbose(bool enabled);     // true 为 LOG_INFO, false 为 LOG_SILENT
+
+    // 从标注文件(每行: 图片 表达式1[;表达式2...])构建字形库, 需在并发调用前加载
+    // 返回加入的样本数, 文件无法打开时返回 -1
+    int loadGlyphBank(const string& labelsPath);
+
+    // 启用容量为 capacity 的字形缓存(0 表示关闭), 需在并发调用前设置
+    void enableGlyphCache(size_t capacity);
+    // 未启用缓存时返回 false
+    bool glyphCacheStats(GlyphCacheStats& stats) const;
+
+    // 配置指纹: 识别器版本 + 字形库(标注文件与模板数据)哈希 + 字形缓存开关,
+    // 识别输出可能变化时随之变化(用作结果缓存键的一部分)
+    string configFingerprint() const;
+
+    // profile 非空时累加各阶段耗时(images 加 1), 为空时不计时
+    FormulaResult recognizeFormula(const Mat& image, RecognitionProfile* profile = nullptr) const;
+    vector<FormulaResult> recognizeMultipleFormulas(const Mat& image,
+                                                    RecognitionProfile* profile = nullptr) const;
+
+    // 条带流式多公式识别: 逐条带二值化, 跨条带边界增量检测公式行, 每行闭合即识别并回调
+    // 峰值内存由条带高度与最高公式行决定, 与页面高度无关; 返回识别的公式行数
+    int recognizeBanded(BandSource& source, int bandRows,
+                        const function<void(const FormulaResult&)>& onRow) const;
+
+    // 视频流增量识别: 整帧静止时直接返回; 否则只重新识别内容变化的公式区域, 其余复用上次结果
+    // 结果在 state.rows 中; 返回各区域的表达式或计算结果是否有变化(含区域增减)
+    bool recognizeStreamFrame(const Mat& frame, StreamState& state) const;
 
-    // 在图片上写入结果并保存
-    void writeResultToImage(const Mat& image, const string& formula, double result,
-                           const string& outputPath);
+    // 在图片上写入结果并保存(profile 非空时计入 rendering 阶段)
+    void writeResultToImage(const Mat& image, const FormulaResult& result,
+                           const string& outputPath, RecognitionProfile* profile = nullptr) const;
     void writeMultipleResultsToImage(const Mat& image, const vector<FormulaResult>& results,
-                                    const string& outputPath);
+                                    const string& outputPath,
+                                    RecognitionProfile* profile = nullptr) const;
 };
 
 #endif // FORMULA_RECOGNIZER_H
@@ -0,0 +1,55 @@
+/**
+ * 公式识别系统 - 字形库实现文件
+ * 低置信度字形的第二级分类器: 对带标注样本做最近邻模板匹配
+ */
+
+#include "glyph_bank.h"
+#include <limits>
+
+// 最近样本距离上限: 超过即认为库中没有相似字形
+static const float kMaxMatchDistance = 0.08f;
+
+void GlyphBank::add(char character, const GlyphTemplate& tmpl) {
+    templates.push_back(tmpl);
+    characters.push_back(character);
+}
+
+bool GlyphBank::empty() const {
+    return templates.empty();
+}
+
+size_t GlyphBank::size() const {
+    return templates.size();
+}
+
+char GlyphBank::classify(const GlyphTemplate& tmpl, float& confidence) const {
+    confidence = 0.0f;
+
+    // 最近样本及其字符, 以及最近的其他字符样本
+    float best = numeric_limits<float>::max();
+    float bestOther = numeric_limits<float>::max();
+    char bestChar = '?';
+
+    for (size_t i = 0; i < templates.size(); i++) {
+        float d = templateDistance(tmpl, templates[i]);
+        if (d < best) {
+            if (characters[i] != bestChar) bestOther = best;
+            best = d;
+            bestChar = characters[i];
+        } else if (d < bestOther && characters[i] != bestChar) {
+            bestOther = d;
+        }
+    }
+
+    if (bestChar == '?' || best > kMaxMatchDistance) {
+        return '?';
+    }
+
+    // 只有一种字符时没有竞争者, 仅按距离给置信度
+    if (bestOther == numeric_limits<float>::max()) {
+        confidence = 1.0f - best / kMaxMatchDistance;
+    } else {
+        confidence = (bestOther - best) / (bestOther + best);
+    }
+    return bestChar;
+}
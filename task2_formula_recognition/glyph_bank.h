@@ -0,0 +1,31 @@
+/**
+ * 公式识别系统 - 字形库头文件
+ * 低置信度字形的第二级分类器: 对带标注样本做最近邻模板匹配
+ */
+
+#ifndef GLYPH_BANK_H
+#define GLYPH_BANK_H
+
+#include "glyph_features.h"
+#include <vector>
+
+using namespace std;
+
+// 字形库: 保存带标注的归一化模板, 按最近邻分类
+// 构建完成后只读, 可被多个线程并发查询
+class GlyphBank {
+private:
+    vector<GlyphTemplate> templates;
+    vector<char> characters;
+
+public:
+    void add(char character, const GlyphTemplate& tmpl);
+    bool empty() const;
+    size_t size() const;
+
+    // 最近邻分类, 距离超过阈值时返回 '?'
+    // confidence 取决于最近样本与最近的其他字符样本的距离差
+    char classify(const GlyphTemplate& tmpl, float& confidence) const;
+};
+
+#endif // GLYPH_BANK_H
@@ -0,0 +1,76 @@
+/**
+ * 公式识别系统 - 字形缓存实现文件
+ * 以字形精确位图为键的有界 LRU 缓存, 记忆字形分类结果
+ */
+
+#include "glyph_cache.h"
+
+GlyphCache::GlyphCache(size_t capacity)
+    : capacity(capacity > 0 ? capacity : 1),
+      shardCapacity((this->capacity + kShardCount - 1) / kShardCount) {
+    for (int i = 0; i < kShardCount; i++) {
+        shards[i].index.reserve(shardCapacity);
+    }
+}
+
+bool GlyphCache::lookup(const GlyphKey& key, char& character, float& confidence) {
+    Shard& shard = shardFor(key);
+    lock_guard<mutex> guard(shard.lock);
+
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        shard.misses++;
+        return false;
+    }
+
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    character = it->second->character;
+    confidence = it->second->confidence;
+    shard.hits++;
+    return true;
+}
+
+void GlyphCache::insert(const GlyphKey& key, char character, float confidence) {
+    Shard& shard = shardFor(key);
+    lock_guard<mutex> guard(shard.lock);
+
+    // 多个线程可能同时未命中同一字形, 结果相同, 后到的只刷新位置
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return;
+    }
+
+    if (shard.entries.size() >= shardCapacity) {
+        shard.index.erase(shard.entries.back().key);
+        shard.entries.pop_back();
+    }
+
+    shard.entries.push_front(Entry{key, character, confidence});
+    shard.index[key] = shard.entries.begin();
+}
+
+void GlyphCache::clear() {
+    for (int i = 0; i < kShardCount; i++) {
+        lock_guard<mutex> guard(shards[i].lock);
+        shards[i].entries.clear();
+        shards[i].index.clear();
+        shards[i].hits = 0;
+        shards[i].misses = 0;
+    }
+}
+
+GlyphCacheStats GlyphCache::stats() const {
+    GlyphCacheStats s;
+    s.hits = 0;
+    s.misses = 0;
+    s.size = 0;
+    s.capacity = capacity;
+    for (int i = 0; i < kShardCount; i++) {
+        lock_guard<mutex> guard(shards[i].lock);
+        s.hits += shards[i].hits;
+        s.misses += shards[i].misses;
+        s.size += shards[i].entries.size();
+    }
+    return s;
+}
@@ -0,0 +1,69 @@
+/**
+ * 公式识别系统 - 字形缓存头文件
+ * 以字形精确位图为键的有界 LRU 缓存, 记忆字形分类结果
+ */
+
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include "glyph_features.h"
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+using namespace std;
+
+// 缓存统计
+struct GlyphCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    size_t size;
+    size_t capacity;
+};
+
+// 字形缓存: 渲染生成的工作表中像素完全相同的字形反复出现, 命中时跳过特征提取、规则级联与字形库匹配
+// 键为精确位图, 命中结果与重新分类完全一致, 不随线程调度变化
+// 按摘要分为 kShardCount 个分片, 各自加锁与淘汰, 多个识别线程共享时锁竞争分散
+class GlyphCache {
+private:
+    static const int kShardCount = 16;
+
+    struct Entry {
+        GlyphKey key;
+        char character;
+        float confidence;
+    };
+
+    struct KeyHash {
+        size_t operator()(const GlyphKey& key) const { return key.hash(); }
+    };
+
+    struct Shard {
+        mutex lock;
+        list<Entry> entries;   // 表头为最近使用
+        unordered_map<GlyphKey, list<Entry>::iterator, KeyHash> index;
+        uint64_t hits;
+        uint64_t misses;
+
+        Shard() : hits(0), misses(0) {}
+    };
+
+    size_t capacity;
+    size_t shardCapacity;
+    mutable Shard shards[kShardCount];
+
+    Shard& shardFor(const GlyphKey& key) const { return shards[(key.digest >> 60) % kShardCount]; }
+
+public:
+    explicit GlyphCache(size_t capacity);
+
+    // 命中时写出字符与置信度, 并将该项移到表头
+    bool lookup(const GlyphKey& key, char& character, float& confidence);
+    // 插入新项, 超出容量时淘汰最久未使用的一项
+    void insert(const GlyphKey& key, char character, float confidence);
+    void clear();
+
+    GlyphCacheStats stats() const;
+};
+
+#endif // GLYPH_CACHE_H
@@ -0,0 +1,255 @@
+/**
+ * 公式识别系统 - 字形特征实现文件
+ * 在连通域标签图上单次遍历提取字形的形态学特征
+ */
+
+#include "glyph_features.h"
+#include <algorithm>
+#include <cmath>
+
+bool Glyph::hasLabel(int label) const {
+    for (int i = 0; i < numLabels; i++) {
+        if (labels[i] == label) return true;
+    }
+    return false;
+}
+
+// 原特征在 resize 到 28×40 的字形掩码上统计(默认 INTER_LINEAR, 再 countNonZero / findContours),
+// 规则阈值按该网格标定。这里直接由标签图按 OpenCV 通用 CPU 实现的双线性定点系数(11 位)判断每个网格点
+// 是否非零, 不生成掩码和缩放图像。这是对原 resize 的仿真, 只针对 0/255 掩码:
+// - 与 OpenCV 4.11 对照, 随机与笔画掩码(含 56×80、84×120 等整数倍尺寸)逐点相同;
+// - 恰好 2 倍缩小(56×80)时 cv::resize 改用 INTER_AREA; 对二值掩码两者都等价于"2×2 块内有前景即非零"
+//   (双线性权重各为 1/2), 结果相同;
+// - IPP/OpenCL 等其他实现路径的舍入未覆盖, 边界上可能相差个别网格点, 应视为近似
+static const int kGridCols = 28;
+static const int kGridRows = 40;
+static const int kCoefBits = 11;   // INTER_RESIZE_COEF_BITS
+
+// 一个输出坐标的插值源: 源下标 index 与 index+1 的定点权重
+struct LinearTap {
+    int index;
+    int w0;
+    int w1;
+};
+
+// 与 OpenCV resize 的系数计算相同(含单精度取整与边界钳制)
+static void linearTaps(int src, int dst, LinearTap* taps) {
+    double scale = 1.0 / ((double)dst / src);
+    for (int d = 0; d < dst; d++) {
+        float f = (float)((d + 0.5) * scale - 0.5);
+        int i = cvFloor(f);
+        f -= i;
+        if (i < 0) {
+            f = 0;
+            i = 0;
+        }
+        if (i >= src - 1) {
+            f = 0;
+            i = src - 1;
+        }
+        taps[d].index = i;
+        taps[d].w0 = cvRound((1.f - f) * (1 << kCoefBits));
+        taps[d].w1 = cvRound(f * (1 << kCoefBits));
+    }
+}
+
+void extractGlyphFeatures(const Mat& labels, const Glyph& glyph, GlyphFeatures& f) {
+    const Rect& box = glyph.box;
+    int w = box.width;
+    int h = box.height;
+
+    f.width = w;
+    f.height = h;
+    f.aspectRatio = h > 0 ? (float)w / h : 0.0f;
+    f.totalPixels = 0;
+    f.leftPixels = 0;
+    f.rightPixels = 0;
+    f.density = 0.0f;
+    f.topRatio = f.midRatio = f.botRatio = 0.0f;
+    f.numHoles = 0;
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+
+    // 左右像素数在原始分辨率上统计(与原规则一致)
+    int halfW = w / 2;
+    for (int y = 0; y < h; y++) {
+        const int* row = labels.ptr<int>(box.y + y) + box.x;
+        for (int x = 0; x < w; x++) {
+            if (glyph.hasLabel(row[x])) {
+                if (x < halfW) f.leftPixels++;
+                else f.rightPixels++;
+            }
+        }
+    }
+
+    LinearTap xTaps[kGridCols];
+    LinearTap yTaps[kGridRows];
+    linearTaps(w, kGridCols, xTaps);
+    linearTaps(h, kGridRows, yTaps);
+
+    // 归一化网格, 外圈补一圈背景供轮廓计数
+    uchar grid[kGridRows + 2][kGridCols + 2] = {};
+    int rowCounts[kGridRows];
+    for (int gy = 0; gy < kGridRows; gy++) {
+        const LinearTap& ty = yTaps[gy];
+        const int* r0 = labels.ptr<int>(box.y + ty.index) + box.x;
+        const int* r1 = labels.ptr<int>(box.y + std::min(ty.index + 1, h - 1)) + box.x;
+        rowCounts[gy] = 0;
+        for (int gx = 0; gx < kGridCols; gx++) {
+            const LinearTap& tx = xTaps[gx];
+            int x1 = std::min(tx.index + 1, w - 1);
+            // 前景为 255: 输出 = (255·Σ权重 + 2^21) >> 22, 非零即 255·Σ权重 >= 2^21
+            int sum = 0;
+            if (ty.w0 != 0) {
+                if (tx.w0 != 0 && glyph.hasLabel(r0[tx.index])) sum += ty.w0 * tx.w0;
+                if (tx.w1 != 0 && glyph.hasLabel(r0[x1])) sum += ty.w0 * tx.w1;
+            }
+            if (ty.w1 != 0) {
+                if (tx.w0 != 0 && glyph.hasLabel(r1[tx.index])) sum += ty.w1 * tx.w0;
+                if (tx.w1 != 0 && glyph.hasLabel(r1[x1])) sum += ty.w1 * tx.w1;
+            }
+            if (255 * sum >= (1 << (2 * kCoefBits - 1))) {
+                grid[gy + 1][gx + 1] = 1;
+                rowCounts[gy]++;
+            }
+        }
+    }
+
+    // 上/中/下为原网格的三等分行 [0,13)、[13,26)、[26,40)
+    int top = 0, mid = 0, bot = 0;
+    for (int gy = 0; gy < kGridRows; gy++) {
+        if (gy < kGridRows / 3) top += rowCounts[gy];
+        else if (gy < kGridRows * 2 / 3) mid += rowCounts[gy];
+        else bot += rowCounts[gy];
+    }
+    int total = top + mid + bot;
+    f.totalPixels = total;
+    f.density = (float)total / (kGridCols * kGridRows);
+    if (total == 0) {
+        return;
+    }
+    f.topRatio = (float)top / total;
+    f.midRatio = (float)mid / total;
+    f.botRatio = (float)bot / total;
+
+    // 轮廓数(RETR_LIST) = 8连通前景连通域数 + 孔洞数; 孔洞数由欧拉数 E = 连通域数 - 孔洞数 得到
+    int q1 = 0, q3 = 0, qd = 0;  // 位四元组: 1个前景、3个前景、对角2个前景
+    for (int y = 0; y <= kGridRows; y++) {
+        for (int x = 0; x <= kGridCols; x++) {
+            int a = grid[y][x], b = grid[y][x + 1];
+            int c = grid[y + 1][x], d = grid[y + 1][x + 1];
+            int n = a + b + c + d;
+            if (n == 1) q1++;
+            else if (n == 3) q3++;
+            else if (n == 2 && a == d) qd++;
+        }
+    }
+    int euler = (q1 - q3 - 2 * qd) / 4;
+
+    // 网格上的连通域数: 栈上数组做洪水填充, 访问过的点清零
+    int components = 0;
+    short stack[kGridRows * kGridCols];
+    for (int y = 1; y <= kGridRows; y++) {
+        for (int x = 1; x <= kGridCols; x++) {
+            if (!grid[y][x]) continue;
+            components++;
+            int sp = 0;
+            grid[y][x] = 0;
+            stack[sp++] = (short)(y * (kGridCols + 2) + x);
+            while (sp > 0) {
+                int p = stack[--sp];
+                int py = p / (kGridCols + 2), px = p % (kGridCols + 2);
+                for (int dy = -1; dy <= 1; dy++) {
+                    for (int dx = -1; dx <= 1; dx++) {
+                        if (grid[py + dy][px + dx]) {
+                            grid[py + dy][px + dx] = 0;
+                            stack[sp++] = (short)((py + dy) * (kGridCols + 2) + px + dx);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    int holes = components - euler;
+    f.numHoles = std::max(0, components + holes - 1);
+}
+
+void extractGlyphTemplate(const Mat& labels, const Glyph& glyph, GlyphTemplate& tmpl) {
+    const Rect& box = glyph.box;
+    int w = box.width;
+    int h = box.height;
+
+    int hits[kTemplateCells] = {0};
+    int sizes[kTemplateCells] = {0};
+
+    for (int y = 0; y < h; y++) {
+        const int* row = labels.ptr<int>(box.y + y) + box.x;
+        int cellRow = y * kTemplateRows / h * kTemplateCols;
+        for (int x = 0; x < w; x++) {
+            int cell = cellRow + x * kTemplateCols / w;
+            sizes[cell]++;
+            if (glyph.hasLabel(row[x])) hits[cell]++;
+        }
+    }
+
+    // 字形小于网格时部分格子没有像素, 视为背景
+    for (int i = 0; i < kTemplateCells; i++) {
+        tmpl.cells[i] = sizes[i] > 0 ? (float)hits[i] / sizes[i] : 0.0f;
+    }
+    tmpl.aspectRatio = h > 0 ? (float)w / h : 0.0f;
+}
+
+bool GlyphKey::operator==(const GlyphKey& other) const {
+    return width == other.width && height == other.height &&
+           digest == other.digest && bits == other.bits;
+}
+
+void extractGlyphKey(const Mat& labels, const Glyph& glyph, GlyphKey& key) {
+    const Rect& box = glyph.box;
+    int w = box.width;
+    int h = box.height;
+
+    key.width = w;
+    key.height = h;
+    key.bits.assign(((size_t)w * h + 63) / 64, 0);
+
+    size_t bit = 0;
+    for (int y = 0; y < h; y++) {
+        const int* row = labels.ptr<int>(box.y + y) + box.x;
+        for (int x = 0; x < w; x++, bit++) {
+            if (glyph.hasLabel(row[x])) {
+                key.bits[bit / 64] |= (uint64_t)1 << (bit % 64);
+            }
+        }
+    }
+
+    // 按 64 位字混合(murmur 终结函数), 尺寸作为种子
+    uint64_t d = ((uint64_t)(uint32_t)w << 32) | (uint32_t)h;
+    for (uint64_t word : key.bits) {
+        d ^= word;
+        d ^= d >> 33;
+        d *= 0xff51afd7ed558ccdULL;
+        d ^= d >> 33;
+        d *= 0xc4ceb9fe1a85ec53ULL;
+        d ^= d >> 33;
+    }
+    key.digest = d;
+}
+
+float templateDistance(const GlyphTemplate& a, const GlyphTemplate& b) {
+    const float kAspectWeight = 0.5f;
+
+    float sum = 0.0f;
+    for (int i = 0; i < kTemplateCells; i++) {
+        float d = a.cells[i] - b.cells[i];
+        sum += d * d;
+    }
+
+    float aspect = 0.0f;
+    if (a.aspectRatio > 0 && b.aspectRatio > 0) {
+        aspect = std::log(a.aspectRatio / b.aspectRatio);
+    }
+    return sum / kTemplateCells + kAspectWeight * aspect * aspect;
+}
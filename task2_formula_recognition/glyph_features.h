@@ -0,0 +1,80 @@
+/**
+ * 公式识别系统 - 字形特征头文件
+ * 直接在连通域标签图上提取字形的形态学特征, 不生成掩码和缩放图像
+ */
+
+#ifndef GLYPH_FEATURES_H
+#define GLYPH_FEATURES_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+using namespace cv;
+
+// 字形最多由几个连通域组成(普通字符1个, 等号2个, 除号3个)
+const int kMaxGlyphParts = 3;
+
+// 字形: 由一个或多个连通域组成
+struct Glyph {
+    Rect box;              // 外接矩形(行内坐标)
+    int area;              // 前景像素数
+    int labels[kMaxGlyphParts];  // 组成字形的连通域标签
+    int numLabels;
+
+    bool hasLabel(int label) const;
+};
+
+// 字形特征(规则分类器的输入)
+// 密度、分布与孔洞数在 28×40 归一化网格上统计(仿真原 resize 后的掩码, 适用范围见 glyph_features.cpp), 规则阈值按此标定
+struct GlyphFeatures {
+    int width;             // 外接矩形宽
+    int height;            // 外接矩形高
+    float aspectRatio;     // 宽高比
+    float density;         // 网格前景点占比
+    float topRatio;        // 网格上/中/下三部分前景点占比
+    float midRatio;
+    float botRatio;
+    int totalPixels;       // 网格前景点数
+    int leftPixels;        // 原始分辨率左半部分像素数
+    int rightPixels;       // 原始分辨率右半部分像素数
+    int numHoles;          // 网格轮廓数 - 1 (连通域数 + 孔洞数 - 1)
+};
+
+// 归一化字形模板(第二级分类器的输入): 外接矩形划分为固定网格, 每格为前景像素占比
+const int kTemplateCols = 8;
+const int kTemplateRows = 12;
+const int kTemplateCells = kTemplateCols * kTemplateRows;
+
+struct GlyphTemplate {
+    float cells[kTemplateCells];
+    float aspectRatio;     // 网格归一化丢失了宽高比, 单独保留
+};
+
+// 字形精确位图(缓存键): 外接矩形内逐像素打包为位串(行优先, 每像素 1 位), 连同外接矩形尺寸
+// 分类只依赖字形像素与尺寸, 键相同则特征与分类结果必然相同; 摘要只用于分桶, 相等比较逐位进行
+struct GlyphKey {
+    std::vector<uint64_t> bits;
+    int width;
+    int height;
+    uint64_t digest;       // 位串与尺寸的 64 位摘要
+
+    bool operator==(const GlyphKey& other) const;
+    size_t hash() const { return (size_t)digest; }
+};
+
+// 按 OpenCV 双线性插值的定点系数直接由 labels 计算 28×40 网格(只访问插值用到的像素), 全程不分配堆内存
+// 孔洞数由网格上 2×2 位四元组计数得到的欧拉数与连通域数推出(前景8连通)
+void extractGlyphFeatures(const Mat& labels, const Glyph& glyph, GlyphFeatures& features);
+
+// 单次遍历提取归一化模板(栈上计数, 不分配内存), 只对低置信度字形调用
+void extractGlyphTemplate(const Mat& labels, const Glyph& glyph, GlyphTemplate& tmpl);
+
+// 单次遍历打包字形像素为精确位图键(只做标签比较与置位, 比特征提取的 2×2 窗口遍历轻)
+void extractGlyphKey(const Mat& labels, const Glyph& glyph, GlyphKey& key);
+
+// 模板距离: 网格均方差 + 宽高比对数差的平方
+float templateDistance(const GlyphTemplate& a, const GlyphTemplate& b);
+
+#endif // GLYPH_FEATURES_H
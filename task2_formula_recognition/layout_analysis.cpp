@@ -0,0 +1,120 @@
+/**
+ * 公式识别系统 - 版面分析实现文件
+ * 基于积分图的递归 XY-cut, 将多栏工作表切分为相互独立的公式区域
+ */
+
+#include "layout_analysis.h"
+#include "projection_profile.h"
+#include <algorithm>
+
+// 栏间空白至少为行高的该倍数(公式内字符间隙不超过行高的 0.4 倍)
+static const double kColumnGapFactor = 1.0;
+// 栏间空白的最小像素数
+static const int kMinColumnGap = 20;
+// 区域最小高度(高度 - 1 需大于该值)
+static const int kMinRegionHeight = 10;
+
+// ============================================================================
+// InkIntegral 实现
+// ============================================================================
+
+InkIntegral::InkIntegral(const Mat& binary) {
+    // 0/255 转为 0/1 再积分, CV_32S 可容纳 2^31 个前景像素
+    Mat ones;
+    threshold(binary, ones, 0, 1, THRESH_BINARY);
+    integral(ones, sum, CV_32S);
+}
+
+int InkIntegral::count(const Rect& r) const {
+    return sum.at<int>(r.y + r.height, r.x + r.width) - sum.at<int>(r.y, r.x + r.width) -
+           sum.at<int>(r.y + r.height, r.x) + sum.at<int>(r.y, r.x);
+}
+
+void InkIntegral::rowProfile(const Rect& r, vector<int>& profile) const {
+    profile.resize(r.height);
+    int x0 = r.x, x1 = r.x + r.width;
+    for (int i = 0; i < r.height; i++) {
+        const int* top = sum.ptr<int>(r.y + i);
+        const int* bottom = sum.ptr<int>(r.y + i + 1);
+        profile[i] = bottom[x1] - top[x1] - bottom[x0] + top[x0];
+    }
+}
+
+void InkIntegral::colProfile(const Rect& r, vector<int>& profile) const {
+    profile.resize(r.width);
+    const int* top = sum.ptr<int>(r.y);
+    const int* bottom = sum.ptr<int>(r.y + r.height);
+    for (int i = 0; i < r.width; i++) {
+        int x = r.x + i;
+        profile[i] = bottom[x + 1] - top[x + 1] - bottom[x] + top[x];
+    }
+}
+
+// ============================================================================
+// 递归 XY-cut
+// ============================================================================
+
+// 行高估计: 区域内各文本行(水平投影连续区间)高度的中位数
+static int medianRunSize(const vector<Range>& runs) {
+    vector<int> sizes;
+    sizes.reserve(runs.size());
+    for (const auto& run : runs) {
+        sizes.push_back(run.size());
+    }
+    nth_element(sizes.begin(), sizes.begin() + sizes.size() / 2, sizes.end());
+    return sizes[sizes.size() / 2];
+}
+
+static void xyCut(const InkIntegral& ink, const Rect& region, bool horizontalFirst,
+                  vector<Rect>& regions) {
+    vector<int> rows, cols;
+    ink.rowProfile(region, rows);
+    vector<Range> rowRuns = projectionRuns(rows);
+    if (rowRuns.empty()) {
+        return;
+    }
+    ink.colProfile(region, cols);
+    vector<Range> colRuns = projectionRuns(cols);
+
+    // 收缩到墨迹外接矩形
+    Rect box(region.x + colRuns.front().start, region.y + rowRuns.front().start,
+             colRuns.back().end - colRuns.front().start,
+             rowRuns.back().end - rowRuns.front().start);
+
+    // 垂直切分: 只有宽于行高的空白列才是栏间隔, 更窄的间隙合并
+    int columnGap = max(kMinColumnGap, (int)(medianRunSize(rowRuns) * kColumnGapFactor));
+    vector<Range> columns = projectionRuns(cols, columnGap - 1);
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool horizontal = (attempt == 0) == horizontalFirst;
+
+        if (horizontal && rowRuns.size() > 1) {
+            for (const auto& run : rowRuns) {
+                xyCut(ink, Rect(box.x, region.y + run.start, box.width, run.size()), false, regions);
+            }
+            return;
+        }
+        if (!horizontal && columns.size() > 1) {
+            for (const auto& column : columns) {
+                xyCut(ink, Rect(region.x + column.start, box.y, column.size(), box.height), true, regions);
+            }
+            return;
+        }
+    }
+
+    // 两个方向都不可再分: 一个独立的公式区域
+    if (box.height - 1 > kMinRegionHeight) {
+        regions.push_back(box);
+    }
+}
+
+vector<Rect> xyCutRegions(const Mat& binary) {
+    vector<Rect> regions;
+    if (binary.empty()) {
+        return regions;
+    }
+
+    InkIntegral ink(binary);
+    xyCut(ink, Rect(0, 0, binary.cols, binary.rows), true, regions);
+    return regions;
+}
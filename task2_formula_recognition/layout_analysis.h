@@ -0,0 +1,35 @@
+/**
+ * 公式识别系统 - 版面分析头文件
+ * 基于积分图的递归 XY-cut, 将多栏工作表切分为相互独立的公式区域
+ */
+
+#ifndef LAYOUT_ANALYSIS_H
+#define LAYOUT_ANALYSIS_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+// 墨迹积分图: 任意子矩形的前景像素数 O(1) 查询
+class InkIntegral {
+private:
+    Mat sum;               // (rows+1)×(cols+1), CV_32S
+
+public:
+    explicit InkIntegral(const Mat& binary);
+
+    int count(const Rect& region) const;
+    // region 内每行 / 每列的前景像素数, 每项 O(1)
+    void rowProfile(const Rect& region, vector<int>& profile) const;
+    void colProfile(const Rect& region, vector<int>& profile) const;
+};
+
+// 递归 XY-cut 版面切分
+// 水平方向按空白行切分, 垂直方向按宽于行高(至少 20px)的空白列切分, 两个方向交替递归,
+// 直到区域在两个方向上都不可再分; 区域收缩到墨迹外接矩形, 按阅读顺序(先上后下、先左后右)输出
+// 高度不足 12 像素的区域视为噪声丢弃(与原公式行检测规则一致)
+vector<Rect> xyCutRegions(const Mat& binary);
+
+#endif // LAYOUT_ANALYSIS_H
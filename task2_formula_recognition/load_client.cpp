@@ -0,0 +1,173 @@
+/**
+ * 公式识别系统 - 服务压测客户端
+ * 通过 Unix 域套接字向服务模式并发发送请求, 统计吞吐量与延迟分布
+ */
+
+#include "recognition_server.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+void printUsage(const char* program_name) {
+    cout << "公式识别服务压测客户端" << endl;
+    cout << endl;
+    cout << "用法: " << program_name << " --socket <路径> --image <图片路径> [选项]" << endl;
+    cout << endl;
+    cout << "选项:" << endl;
+    cout << "  --requests <N>     请求总数(默认 1000)" << endl;
+    cout << "  --connections <N>  并发连接数(默认 4)" << endl;
+    cout << "  --bytes            发送图片字节(bytes 请求), 默认只发送路径(path 请求)" << endl;
+    cout << "  --single           请求单公式识别模式" << endl;
+    cout << endl;
+}
+
+static int connectSocket(const string& path) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 单个连接的统计
+struct ConnectionStats {
+    vector<double> latencies_ms;
+    int errors;
+};
+
+int main(int argc, char** argv) {
+    string socket_path;
+    string image_path;
+    int total_requests = 1000;
+    int connections = 4;
+    bool send_bytes = false;
+    bool single = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (arg == "--image" && i + 1 < argc) {
+            image_path = argv[++i];
+        } else if (arg == "--requests" && i + 1 < argc) {
+            total_requests = max(1, atoi(argv[++i]));
+        } else if (arg == "--connections" && i + 1 < argc) {
+            connections = max(1, atoi(argv[++i]));
+        } else if (arg == "--bytes") {
+            send_bytes = true;
+        } else if (arg == "--single") {
+            single = true;
+        } else {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (socket_path.empty() || image_path.empty()) {
+        printUsage(argv[0]);
+        return -1;
+    }
+
+    // 预先构造请求, 计时只包含往返
+    string request_line;
+    vector<char> payload;
+    if (send_bytes) {
+        ifstream in(image_path, ios::binary);
+        if (!in.is_open()) {
+            cerr << "错误: 无法读取图像: " << image_path << endl;
+            return -1;
+        }
+        payload.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+        request_line = string("bytes ") + (single ? "--single " : "") + to_string(payload.size()) + "\n";
+    } else {
+        request_line = string("path ") + (single ? "--single " : "") + image_path + "\n";
+    }
+
+    vector<ConnectionStats> stats(connections);
+    vector<thread> threads;
+
+    auto start = chrono::steady_clock::now();
+    for (int c = 0; c < connections; c++) {
+        int count = total_requests / connections + (c < total_requests % connections ? 1 : 0);
+        threads.emplace_back([&, c, count]() {
+            ConnectionStats& st = stats[c];
+            st.errors = 0;
+            st.latencies_ms.reserve(count);
+
+            int fd = connectSocket(socket_path);
+            if (fd < 0) {
+                st.errors = count;
+                return;
+            }
+
+            LineChannel channel(fd, fd);
+            string response;
+            for (int r = 0; r < count; r++) {
+                auto t0 = chrono::steady_clock::now();
+                bool ok = channel.writeAll(request_line.data(), request_line.size()) &&
+                          (payload.empty() || channel.writeAll(payload.data(), payload.size())) &&
+                          channel.readLine(response);
+                auto t1 = chrono::steady_clock::now();
+
+                if (!ok) {
+                    st.errors += count - r;
+                    break;
+                }
+                if (response.find("\"error\"") != string::npos) {
+                    st.errors++;
+                }
+                st.latencies_ms.push_back(chrono::duration<double, milli>(t1 - t0).count());
+            }
+            ::close(fd);
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    double elapsed_sec = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    vector<double> latencies;
+    int errors = 0;
+    for (const auto& st : stats) {
+        latencies.insert(latencies.end(), st.latencies_ms.begin(), st.latencies_ms.end());
+        errors += st.errors;
+    }
+    if (latencies.empty()) {
+        cerr << "错误: 无法连接服务: " << socket_path << endl;
+        return -1;
+    }
+    sort(latencies.begin(), latencies.end());
+
+    auto percentile = [&](double p) {
+        size_t idx = min(latencies.size() - 1, (size_t)(p * latencies.size()));
+        return latencies[idx];
+    };
+
+    cout << "请求: " << latencies.size() << " 完成, " << errors << " 失败, "
+         << connections << " 个连接" << endl;
+    cout << fixed << setprecision(1)
+         << "吞吐量: " << latencies.size() / elapsed_sec << " req/s" << endl;
+    cout << setprecision(2)
+         << "延迟(ms): p50 " << percentile(0.50) << "  p90 " << percentile(0.90)
+         << "  p99 " << percentile(0.99) << "  max " << latencies.back() << endl;
+
+    return errors == 0 ? 0 : 1;
+}
@@ -4,7 +4,16 @@
  */
 
 #include "formula_recognizer.h"
+#include "batch_processor.h"
+#include "mat_pool.h"
+#include "formula_json.h"
+#include "recognition_server.h"
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <sstream>
 
 using namespace std;
 
@@ -12,27 +21,448 @@ void printUsage(const char* program_name) {
     cout << "公式识别系统 v1.0" << endl;
     cout << endl;
     cout << "用法: " << program_name << " <图像路径> [选项]" << endl;
+    cout << "      " << program_name << " --batch <目录|通配符|列表文件> [批量选项]" << endl;
+    cout << "      " << program_name << " --serve [服务选项]" << endl;
+    cout << "      " << program_name << " --video <视频文件|摄像头编号> [视频选项]" << endl;
     cout << endl;
     cout << "选项:" << endl;
     cout << "  --output <路径>  将结果写入图片并保存" << endl;
     cout << "  --single        强制单公式识别模式(默认自动检测多公式)" << endl;
+    cout << "  --glyph-bank <标注文件>  从标注图片构建字形库, 低置信度字形用模板匹配复核" << endl;
+    cout << "  --json          只向标准输出写 JSON 结果, 不生成结果图片(配合 --output 仍可渲染)" << endl;
+    cout << "  --stream        条带流式识别超高页面, 每个公式行闭合即输出(.pgm 直接从磁盘分段读取)" << endl;
+    cout << "  --band-rows <N> 流式识别的条带高度(默认 256 行)" << endl;
+    cout << "  --log-level <级别>  识别过程输出: silent / warn / info(默认 info)" << endl;
+    cout << "  --profile       输出分阶段耗时(预处理、行检测、分割、分类、计算、渲染)" << endl;
+    cout << endl;
+    cout << "批量选项:" << endl;
+    cout << "  --results <路径>     汇总结果文件, 每行一个JSON对象(默认 batch_results.jsonl)" << endl;
+    cout << "  --workers <N>        识别线程数(默认 CPU 核数)" << endl;
+    cout << "  --io-threads <N>     解码线程数(默认 2)" << endl;
+    cout << "  --write-images       为每张图片生成 _result.png" << endl;
+    cout << "  --single             强制单公式识别模式" << endl;
+    cout << "  --glyph-bank <路径>  同上" << endl;
+    cout << "  --glyph-cache <N>    按精确像素缓存字形分类结果的容量(默认 0, 关闭)" << endl;
+    cout << "  --result-cache <目录>  按文件内容缓存识别结果, 重复图片跳过解码与识别" << endl;
+    cout << "                       (与 --write-images 同用时只写入不查找, 每张图片都识别并生成结果图片)" << endl;
+    cout << "  --result-cache-mb <N>  结果缓存占用上限, 超出后淘汰最久未用的条目(默认 256)" << endl;
+    cout << "  --profile            每张图片的结果附带分阶段耗时, 结束时输出汇总" << endl;
+    cout << "  --mat-pool           Mat 缓冲区使用按尺寸分级的内存池, 结束时输出内存池统计" << endl;
+    cout << endl;
+    cout << "服务选项:" << endl;
+    cout << "  --socket <路径>      监听 Unix 域套接字(默认使用标准输入/输出行协议)" << endl;
+    cout << "  --single             默认单公式识别模式(请求可单独指定)" << endl;
+    cout << "  --glyph-bank <路径>  同上" << endl;
+    cout << "  --glyph-cache <N>    同上" << endl;
+    cout << "  --result-cache <目录>  同上" << endl;
+    cout << "  --result-cache-mb <N>  同上" << endl;
+    cout << endl;
+    cout << "视频选项:" << endl;
+    cout << "  --every <N>          每 N 帧处理一帧(默认 1)" << endl;
+    cout << "  --max-frames <N>     最多读取 N 帧后停止(默认读到结束)" << endl;
+    cout << "  --json               每次结果变化输出一行 JSON" << endl;
+    cout << "  --glyph-bank <路径>  同上" << endl;
     cout << endl;
     cout << "示例:" << endl;
     cout << "  " << program_name << " images/formula.png" << endl;
     cout << "  " << program_name << " images/formula.png --output result.png" << endl;
     cout << "  " << program_name << " images/formula.png --single  # 强制单公式模式" << endl;
+    cout << "  " << program_name << " images/formula.png --json > result.json" << endl;
+    cout << "  " << program_name << " images/formula.png --glyph-bank formula_images/glyph_labels.txt" << endl;
+    cout << "  " << program_name << " --batch images/ --results results.jsonl" << endl;
+    cout << "  " << program_name << " --batch \"images/*.png\" --workers 8" << endl;
+    cout << "  " << program_name << " --batch images/ --result-cache ~/.cache/formula" << endl;
+    cout << "  " << program_name << " --serve --socket /tmp/formula.sock" << endl;
+    cout << "  " << program_name << " --video 0 --every 3   # 摄像头, 每 3 帧识别一次" << endl;
     cout << endl;
 }
 
+// 加载字形库(第二级分类器); 提示信息写到 stderr, 不干扰 JSON 模式的标准输出
+bool loadGlyphBank(FormulaRecognizer& recognizer, const string& labels_path) {
+    int samples = recognizer.loadGlyphBank(labels_path);
+    if (samples < 0) {
+        cerr << "错误: 无法读取字形库标注文件: " << labels_path << endl;
+        return false;
+    }
+    clog << "字形库: " << samples << " 个样本 (" << labels_path << ")" << endl;
+    return true;
+}
+
+// 计算结果的文字形式; 表达式无法计算时给出原因
+string resultValueText(const FormulaResult& result) {
+    if (!result.error.empty()) {
+        return "无法计算 (" + result.error + ")";
+    }
+    stringstream ss;
+    ss << result.result;
+    return ss.str();
+}
+
+// 解析日志级别, 无法识别时返回 false
+bool parseLogLevel(const string& name, LogLevel& level) {
+    if (name == "silent") {
+        level = LOG_SILENT;
+    } else if (name == "warn") {
+        level = LOG_WARN;
+    } else if (name == "info") {
+        level = LOG_INFO;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// 分阶段耗时汇总(每张图片平均), 写到 stderr
+void printProfile(const RecognitionProfile& profile) {
+    int images = max(1, profile.images);
+    clog << "分阶段耗时 (" << profile.images << " 张图片, 每张平均):" << endl;
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        RecognitionStage stage = static_cast<RecognitionStage>(s);
+        double ms = profile.stage_ms[s] / images;
+        double share = profile.totalMs() > 0 ? 100.0 * profile.stage_ms[s] / profile.totalMs() : 0.0;
+        clog << "  " << RecognitionProfile::stageName(stage) << ": " << ms << " ms ("
+             << (int)(share + 0.5) << "%)" << endl;
+    }
+    clog << "  total: " << profile.totalMs() / images << " ms" << endl;
+}
+
+// 打开结果缓存; 键包含识别器配置指纹, 需在加载字形库之后调用
+unique_ptr<ResultCache> openResultCache(const FormulaRecognizer& recognizer, const string& dir,
+                                        int max_mb) {
+    unique_ptr<ResultCache> cache(new ResultCache(dir, (uint64_t)max(1, max_mb) << 20,
+                                                  recognizer.configFingerprint()));
+    if (!cache->open()) {
+        cerr << "错误: 无法创建结果缓存目录: " << dir << endl;
+        return unique_ptr<ResultCache>();
+    }
+    return cache;
+}
+
+// JSON 模式: 标准输出只有一行 JSON, 不复制、不绘制、不编码图片; 指定 --output 时才渲染
+// profile 非空时 JSON 附带 timing_ms(渲染在输出 JSON 之后进行, 不计入)
+int runJson(FormulaRecognizer& recognizer, const Mat& image, const string& image_path,
+            bool multi_mode, const string& output_path, RecognitionProfile* profile) {
+    recognizer.setVerbose(false);
+
+    vector<FormulaResult> results;
+    if (multi_mode) {
+        results = recognizer.recognizeMultipleFormulas(image, profile);
+    } else {
+        results.push_back(recognizer.recognizeFormula(image, profile));
+    }
+
+    cout << imageResultsToJson(image_path, results, "", profile) << endl;
+
+    if (!output_path.empty()) {
+        if (multi_mode) {
+            recognizer.writeMultipleResultsToImage(image, results, output_path);
+        } else {
+            recognizer.writeResultToImage(image, results[0], output_path);
+        }
+    }
+    return 0;
+}
+
+// 流式模式: 按条带读取与二值化, 每个公式行闭合即输出; 不保留整页, 因此不生成结果图片
+int runStream(FormulaRecognizer& recognizer, const string& image_path, int band_rows,
+              bool json_mode) {
+    unique_ptr<BandSource> source = openBandSource(image_path);
+    if (!source) {
+        cerr << "错误: 无法读取图像: " << image_path << endl;
+        return -1;
+    }
+
+    if (json_mode) {
+        recognizer.setVerbose(false);
+    }
+
+    int index = 0;
+    recognizer.recognizeBanded(*source, band_rows, [&](const FormulaResult& result) {
+        index++;
+        if (json_mode) {
+            // 每行一个 JSON 对象
+            cout << formulaResultToJson(result) << endl;
+        } else {
+            cout << "公式 " << index << " (y=" << result.boundingBox.y << "): "
+                 << result.expression << "  计算结果: " << resultValueText(result) << endl;
+        }
+    });
+
+    if (!json_mode) {
+        cout << "✓ 共识别 " << index << " 个公式行 (页面 " << source->width() << "×"
+             << source->height() << ", 条带 " << band_rows << " 行)" << endl;
+    }
+    return 0;
+}
+
+// 批量模式: I/O 线程解码, 线程池识别, 汇总写入单个结果文件
+int runBatch(int argc, char** argv) {
+    string spec = argv[2];
+    string results_path = "batch_results.jsonl";
+    string glyph_bank_path = "";
+    int glyph_cache_capacity = 0;
+    string result_cache_dir = "";
+    int result_cache_mb = 256;
+    BatchOptions options;
+
+    for (int i = 3; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--results" && i + 1 < argc) {
+            results_path = argv[++i];
+        } else if (arg == "--workers" && i + 1 < argc) {
+            options.workers = atoi(argv[++i]);
+        } else if (arg == "--io-threads" && i + 1 < argc) {
+            options.io_threads = atoi(argv[++i]);
+        } else if (arg == "--write-images") {
+            options.write_images = true;
+        } else if (arg == "--single") {
+            options.multi_mode = false;
+        } else if (arg == "--glyph-bank" && i + 1 < argc) {
+            glyph_bank_path = argv[++i];
+        } else if (arg == "--glyph-cache" && i + 1 < argc) {
+            glyph_cache_capacity = atoi(argv[++i]);
+        } else if (arg == "--result-cache" && i + 1 < argc) {
+            result_cache_dir = argv[++i];
+        } else if (arg == "--result-cache-mb" && i + 1 < argc) {
+            result_cache_mb = atoi(argv[++i]);
+        } else if (arg == "--profile") {
+            options.profile = true;
+        } else if (arg == "--mat-pool") {
+            options.mat_pool = true;
+        }
+    }
+
+    vector<string> paths = BatchProcessor::collectInputs(spec);
+    if (paths.empty()) {
+        cerr << "错误: 未找到输入图像: " << spec << endl;
+        return -1;
+    }
+
+    cout << "批量识别: " << paths.size() << " 张图片, "
+         << options.workers << " 个识别线程, " << options.io_threads << " 个解码线程" << endl;
+
+    FormulaRecognizer recognizer;
+    recognizer.setVerbose(false);
+    if (!glyph_bank_path.empty() && !loadGlyphBank(recognizer, glyph_bank_path)) {
+        return -1;
+    }
+    recognizer.enableGlyphCache(glyph_cache_capacity > 0 ? glyph_cache_capacity : 0);
+    unique_ptr<ResultCache> result_cache;
+    if (!result_cache_dir.empty()) {
+        result_cache = openResultCache(recognizer, result_cache_dir, result_cache_mb);
+        if (!result_cache) {
+            return -1;
+        }
+        options.result_cache = result_cache.get();
+    }
+    BatchProcessor processor(recognizer, options);
+
+    TickMeter tm;
+    tm.start();
+    vector<BatchItem> items = processor.run(paths);
+    tm.stop();
+
+    int failed = 0;
+    for (const auto& item : items) {
+        if (!item.error.empty()) {
+            cerr << "错误: " << item.path << ": " << item.error << endl;
+            failed++;
+        }
+    }
+
+    if (!BatchProcessor::writeResults(results_path, items)) {
+        cerr << "错误: 无法写入结果文件: " << results_path << endl;
+        return -1;
+    }
+
+    cout << "完成: " << (items.size() - failed) << " 成功, " << failed << " 失败, 用时 "
+         << tm.getTimeSec() << " 秒 (" << items.size() / tm.getTimeSec() << " 张/秒)" << endl;
+
+    GlyphCacheStats cache;
+    if (recognizer.glyphCacheStats(cache)) {
+        uint64_t lookups = cache.hits + cache.misses;
+        cout << "字形缓存: 命中 " << cache.hits << ", 未命中 " << cache.misses
+             << ", 命中率 " << (lookups > 0 ? 100.0 * cache.hits / lookups : 0.0) << "%"
+             << ", 占用 " << cache.size << "/" << cache.capacity << endl;
+    }
+    if (result_cache) {
+        ResultCacheStats rc = result_cache->stats();
+        cout << "结果缓存: 命中 " << rc.hits << ", 未命中 " << rc.misses << ", 写入 " << rc.stores
+             << ", 淘汰 " << rc.evictions << ", 占用 " << (rc.bytes >> 10) << " KB" << endl;
+    }
+    if (options.mat_pool) {
+        MatPoolStats pool = PooledMatAllocator::instance().stats();
+        uint64_t hits = pool.thread_hits + pool.shared_hits;
+        cout << "Mat 内存池: 申请 " << pool.allocations << ", 复用 " << hits
+             << " (本线程 " << pool.thread_hits << ", 共享 " << pool.shared_hits << ")"
+             << ", 系统分配 " << pool.system_allocs << ", 系统释放 " << pool.system_frees
+             << ", 峰值 " << (pool.peak_bytes >> 10) << " KB" << endl;
+    }
+    if (options.profile) {
+        printProfile(BatchProcessor::aggregateProfile(items));
+    }
+    cout << "✓ 结果已写入: " << results_path << endl;
+
+    return failed == 0 ? 0 : 1;
+}
+
+// 服务模式: 常驻进程保持识别器与字形缓存预热, 逐请求返回 JSON
+int runServe(int argc, char** argv) {
+    string glyph_bank_path = "";
+    int glyph_cache_capacity = 0;
+    string result_cache_dir = "";
+    int result_cache_mb = 256;
+    ServerOptions options;
+
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            options.socket_path = argv[++i];
+        } else if (arg == "--single") {
+            options.multi_mode = false;
+        } else if (arg == "--glyph-bank" && i + 1 < argc) {
+            glyph_bank_path = argv[++i];
+        } else if (arg == "--glyph-cache" && i + 1 < argc) {
+            glyph_cache_capacity = atoi(argv[++i]);
+        } else if (arg == "--result-cache" && i + 1 < argc) {
+            result_cache_dir = argv[++i];
+        } else if (arg == "--result-cache-mb" && i + 1 < argc) {
+            result_cache_mb = atoi(argv[++i]);
+        }
+    }
+
+    FormulaRecognizer recognizer;
+    recognizer.setVerbose(false);
+    if (!glyph_bank_path.empty() && !loadGlyphBank(recognizer, glyph_bank_path)) {
+        return -1;
+    }
+    recognizer.enableGlyphCache(glyph_cache_capacity > 0 ? glyph_cache_capacity : 0);
+    unique_ptr<ResultCache> result_cache;
+    if (!result_cache_dir.empty()) {
+        result_cache = openResultCache(recognizer, result_cache_dir, result_cache_mb);
+        if (!result_cache) {
+            return -1;
+        }
+        options.result_cache = result_cache.get();
+    }
+
+    RecognitionServer server(recognizer, options);
+    return server.run();
+}
+
+// 视频/摄像头模式: 只重新识别内容变化的公式区域, 结果变化时才输出
+int runVideo(int argc, char** argv) {
+    string source = argv[2];
+    int every = 1;
+    long max_frames = -1;
+    bool json_mode = false;
+    string glyph_bank_path = "";
+
+    for (int i = 3; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--every" && i + 1 < argc) {
+            every = max(1, atoi(argv[++i]));
+        } else if (arg == "--max-frames" && i + 1 < argc) {
+            max_frames = atol(argv[++i]);
+        } else if (arg == "--json") {
+            json_mode = true;
+        } else if (arg == "--glyph-bank" && i + 1 < argc) {
+            glyph_bank_path = argv[++i];
+        }
+    }
+
+    // 纯数字视为摄像头编号
+    VideoCapture capture;
+    bool is_camera = !source.empty() && source.find_first_not_of("0123456789") == string::npos;
+    if (is_camera) {
+        capture.open(atoi(source.c_str()));
+    } else {
+        capture.open(source);
+    }
+    if (!capture.isOpened()) {
+        cerr << "错误: 无法打开视频源: " << source << endl;
+        return -1;
+    }
+
+    FormulaRecognizer recognizer;
+    recognizer.setVerbose(false);
+    if (!glyph_bank_path.empty() && !loadGlyphBank(recognizer, glyph_bank_path)) {
+        return -1;
+    }
+
+    StreamState state;
+    Mat frame;
+    long frame_index = 0;
+    int updates = 0;
+    TickMeter tm;
+    tm.start();
+
+    while ((max_frames < 0 || frame_index < max_frames) && capture.read(frame)) {
+        long index = frame_index++;
+        if (frame.empty() || index % every != 0) continue;
+        if (!recognizer.recognizeStreamFrame(frame, state)) continue;
+
+        updates++;
+        if (json_mode) {
+            vector<FormulaResult> results;
+            for (const auto& row : state.rows) results.push_back(row.result);
+            cout << "{\"frame\":" << index << ",\"formulas\":" << formulasToJson(results) << "}" << endl;
+        } else {
+            cout << "[帧 " << index << "] " << state.rows.size() << " 个公式" << endl;
+            for (size_t i = 0; i < state.rows.size(); i++) {
+                const FormulaResult& result = state.rows[i].result;
+                cout << "  公式 " << (i + 1) << ": " << result.expression
+                     << "  计算结果: " << resultValueText(result) << endl;
+            }
+        }
+    }
+    tm.stop();
+
+    uint64_t processed = state.frames - state.stillFrames;
+    uint64_t rows = state.recognizedRows + state.reusedRows;
+    clog << "视频结束: 读取 " << frame_index << " 帧, 处理 " << state.frames << " 帧 (静止跳过 "
+         << state.stillFrames << "), 结果更新 " << updates << " 次, 用时 " << tm.getTimeSec() << " 秒" << endl;
+    clog << "公式区域: 重新识别 " << state.recognizedRows << ", 复用 " << state.reusedRows
+         << " (复用率 " << (rows > 0 ? 100.0 * state.reusedRows / rows : 0.0) << "%, 每处理帧平均 "
+         << (processed > 0 ? (double)rows / processed : 0.0) << " 个区域)" << endl;
+    return 0;
+}
+
 int main(int argc, char** argv) {
     if (argc < 2) {
         printUsage(argv[0]);
         return -1;
     }
 
+    if (string(argv[1]) == "--batch") {
+        if (argc < 3) {
+            printUsage(argv[0]);
+            return -1;
+        }
+        return runBatch(argc, argv);
+    }
+
+    if (string(argv[1]) == "--serve") {
+        return runServe(argc, argv);
+    }
+
+    if (string(argv[1]) == "--video") {
+        if (argc < 3) {
+            printUsage(argv[0]);
+            return -1;
+        }
+        return runVideo(argc, argv);
+    }
+
     string image_path = argv[1];
     string output_path = "";
     bool multi_mode = true;
+    bool json_mode = false;
+    bool stream_mode = false;
+    int band_rows = 256;
+    string glyph_bank_path = "";
+    LogLevel log_level = LOG_INFO;
+    bool profile_mode = false;
 
     for (int i = 2; i < argc; i++) {
         string arg = argv[i];
@@ -41,62 +471,86 @@ int main(int argc, char** argv) {
             i++;  // 跳过下一个参数
         } else if (arg == "--single") {
             multi_mode = false;
+        } else if (arg == "--json") {
+            json_mode = true;
+        } else if (arg == "--stream") {
+            stream_mode = true;
+        } else if (arg == "--band-rows" && i + 1 < argc) {
+            band_rows = max(8, atoi(argv[++i]));
+        } else if (arg == "--glyph-bank" && i + 1 < argc) {
+            glyph_bank_path = argv[++i];
+        } else if (arg == "--log-level" && i + 1 < argc) {
+            if (!parseLogLevel(argv[++i], log_level)) {
+                cerr << "错误: 未知的日志级别: " << argv[i] << endl;
+                return -1;
+            }
+        } else if (arg == "--profile") {
+            profile_mode = true;
         }
     }
 
+    FormulaRecognizer recognizer;
+    recognizer.setLogLevel(log_level);
+    RecognitionProfile profile;
+    RecognitionProfile* profile_ptr = profile_mode ? &profile : nullptr;
+    if (!glyph_bank_path.empty() && !loadGlyphBank(recognizer, glyph_bank_path)) {
+        return -1;
+    }
+
+    if (stream_mode) {
+        return runStream(recognizer, image_path, band_rows, json_mode);
+    }
+
     Mat image = imread(image_path);
     if (image.empty()) {
         cerr << "错误: 无法读取图像: " << image_path << endl;
         return -1;
     }
 
-    FormulaRecognizer recognizer;
+    if (json_mode) {
+        return runJson(recognizer, image, image_path, multi_mode, output_path, profile_ptr);
+    }
+
     if (output_path.empty()) {
         // 自动生成输出文件名: 原文件名_result.png
-        size_t lastSlash = image_path.find_last_of("/\\");
-        size_t lastDot = image_path.find_last_of(".");
-
-        string baseDir = (lastSlash != string::npos) ? image_path.substr(0, lastSlash + 1) : "";
-        string baseName = (lastSlash != string::npos) ? image_path.substr(lastSlash + 1) : image_path;
-
-        if (lastDot != string::npos && lastDot > lastSlash) {
-            baseName = baseName.substr(0, lastDot - (lastSlash != string::npos ? lastSlash + 1 : 0));
-        }
-
-        output_path = baseDir + baseName + "_result.png";
+        output_path = resultImagePath(image_path);
     }
 
     // 根据模式进行识别
     if (multi_mode) {
         // 多公式识别模式
-        vector<FormulaResult> results = recognizer.recognizeMultipleFormulas(image);
+        vector<FormulaResult> results = recognizer.recognizeMultipleFormulas(image, profile_ptr);
 
         cout << "\n========== 识别结果 ==========" << endl;
         for (size_t i = 0; i < results.size(); i++) {
             cout << "公式 " << (i + 1) << ": " << results[i].expression << endl;
-            cout << "计算结果: " << results[i].result << endl;
+            cout << "计算结果: " << resultValueText(results[i]) << endl;
             cout << "------------------------------" << endl;
         }
         cout << "==============================\n" << endl;
 
         // 将所有结果写入图片
-        recognizer.writeMultipleResultsToImage(image, results, output_path);
+        recognizer.writeMultipleResultsToImage(image, results, output_path, profile_ptr);
         cout << "✓ 结果已写入图片: " << output_path << endl;
 
     } else {
         // 单公式识别模式
-        auto result = recognizer.recognizeFormula(image);
+        FormulaResult result = recognizer.recognizeFormula(image, profile_ptr);
 
         cout << "\n========== 识别结果 ==========" << endl;
-        cout << "公式: " << result.first << endl;
-        cout << "计算结果: " << result.second << endl;
+        cout << "公式: " << result.expression << endl;
+        cout << "计算结果: " << resultValueText(result) << endl;
         cout << "==============================\n" << endl;
 
         // 将结果写入图片
-        recognizer.writeResultToImage(image, result.first, result.second, output_path);
+        recognizer.writeResultToImage(image, result, output_path, profile_ptr);
         cout << "✓ 结果已写入图片: " << output_path << endl;
     }
 
+    if (profile_mode) {
+        printProfile(profile);
+    }
+
     // 只在有显示环境时显示窗口
     const char* display = getenv("DISPLAY");
     if (display != nullptr && strlen(display) > 0) {
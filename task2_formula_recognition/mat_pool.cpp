@@ -0,0 +1,234 @@
+/**
+ * 公式识别系统 - Mat 内存池实现文件
+ * 按尺寸分级缓存 Mat 数据块的 cv::MatAllocator, 批量识别时各线程在图片之间复用缓冲区
+ */
+
+#include "mat_pool.h"
+#include <new>
+
+// 本线程缓存的生命周期状态; 无析构函数的 thread_local, 线程退出的整个过程中都可读
+enum ThreadCacheState { CACHE_UNUSED = 0, CACHE_ALIVE, CACHE_DESTROYED };
+static thread_local int threadCacheState = CACHE_UNUSED;
+
+// 每个线程的空闲块缓存, 只被本线程访问
+struct ThreadCache {
+    vector<void*> blocks[PooledMatAllocator::kClassCount];
+    size_t bytes;
+
+    ThreadCache() : bytes(0) {
+        threadCacheState = CACHE_ALIVE;
+    }
+    ~ThreadCache() {
+        threadCacheState = CACHE_DESTROYED;
+        if (bytes > 0) {
+            PooledMatAllocator::instance().drainThreadCache(blocks, bytes);
+        }
+    }
+};
+
+static thread_local ThreadCache threadCache;
+
+// 本线程缓存(首次访问时构造); 线程退出时缓存已析构后仍可能有 Mat 被释放
+// (其他 thread_local 或 OpenCV 自身的 TLS 析构顺序不定), 此时返回 nullptr, 调用方改走共享缓存或系统
+static ThreadCache* localCache() {
+    if (threadCacheState == CACHE_DESTROYED) {
+        return nullptr;
+    }
+    return &threadCache;
+}
+
+// ============================================================================
+// 尺寸分级
+// ============================================================================
+
+int PooledMatAllocator::sizeClass(size_t size, size_t& class_size) {
+    if (size <= kMinBlock) {
+        class_size = kMinBlock;
+        return 0;
+    }
+
+    // 2^p < size <= 2^(p+1), 区间内按 2^p / 4 分 4 级
+    int p = kMinShift;
+    while (((size_t)1 << (p + 1)) < size) {
+        p++;
+        if (p >= kMaxShift) return -1;
+    }
+    size_t base = (size_t)1 << p;
+    size_t step = base / 4;
+    size_t q = (size - base + step - 1) / step;
+    class_size = base + q * step;
+    return (p - kMinShift) * 4 + (int)q;
+}
+
+size_t PooledMatAllocator::classBytes(int c) {
+    if (c == 0) {
+        return kMinBlock;
+    }
+    size_t base = (size_t)1 << (kMinShift + (c - 1) / 4);
+    return base + (size_t)((c - 1) % 4 + 1) * (base / 4);
+}
+
+// ============================================================================
+// PooledMatAllocator
+// ============================================================================
+
+PooledMatAllocator::PooledMatAllocator()
+    : shared_bytes(0), allocations(0), thread_hits(0), shared_hits(0),
+      system_allocs(0), system_frees(0), bytes_in_use(0), peak_bytes(0) {}
+
+PooledMatAllocator& PooledMatAllocator::instance() {
+    static PooledMatAllocator* pool = new PooledMatAllocator();
+    return *pool;
+}
+
+void* PooledMatAllocator::acquire(size_t size) const {
+    allocations++;
+
+    size_t class_size = size;
+    int c = sizeClass(size, class_size);
+    void* block = nullptr;
+
+    if (c >= 0) {
+        ThreadCache* cache = localCache();
+        if (cache != nullptr && !cache->blocks[c].empty()) {
+            block = cache->blocks[c].back();
+            cache->blocks[c].pop_back();
+            cache->bytes -= class_size;
+            thread_hits++;
+        } else {
+            lock_guard<mutex> lock(shared_lock);
+            if (!shared_free[c].empty()) {
+                block = shared_free[c].back();
+                shared_free[c].pop_back();
+                shared_bytes -= class_size;
+                shared_hits++;
+            }
+        }
+    }
+
+    if (block == nullptr) {
+        block = fastMalloc(class_size);
+        system_allocs++;
+    }
+
+    uint64_t in_use = bytes_in_use.fetch_add(class_size) + class_size;
+    uint64_t peak = peak_bytes.load();
+    while (in_use > peak && !peak_bytes.compare_exchange_weak(peak, in_use)) {
+    }
+    return block;
+}
+
+void PooledMatAllocator::release(void* block, size_t size) const {
+    size_t class_size = size;
+    int c = sizeClass(size, class_size);
+    bytes_in_use.fetch_sub(class_size);
+
+    if (c >= 0) {
+        // 优先放回本线程缓存, 其次共享缓存
+        ThreadCache* cache = localCache();
+        if (cache != nullptr && cache->bytes + class_size <= kThreadCacheBytes) {
+            cache->blocks[c].push_back(block);
+            cache->bytes += class_size;
+            return;
+        }
+        lock_guard<mutex> lock(shared_lock);
+        if (shared_bytes + class_size <= kSharedCacheBytes) {
+            shared_free[c].push_back(block);
+            shared_bytes += class_size;
+            return;
+        }
+    }
+
+    fastFree(block);
+    system_frees++;
+}
+
+UMatData* PooledMatAllocator::allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                                       AccessFlag, UMatUsageFlags) const {
+    // 与 OpenCV 标准分配器相同的步长计算
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; i--) {
+        if (step) {
+            if (data && step[i] != CV_AUTOSTEP) {
+                CV_Assert(total <= step[i]);
+                total = step[i];
+            } else {
+                step[i] = total;
+            }
+        }
+        total *= sizes[i];
+    }
+
+    UMatData* u = new (acquire(sizeof(UMatData))) UMatData(this);
+    u->data = u->origdata = data ? (uchar*)data : (uchar*)acquire(total);
+    u->size = total;
+    if (data) {
+        u->flags |= UMatData::USER_ALLOCATED;
+    }
+    return u;
+}
+
+bool PooledMatAllocator::allocate(UMatData* data, AccessFlag, UMatUsageFlags) const {
+    return data != nullptr;
+}
+
+void PooledMatAllocator::deallocate(UMatData* u) const {
+    if (u == nullptr) {
+        return;
+    }
+    CV_Assert(u->urefcount == 0);
+    CV_Assert(u->refcount == 0);
+
+    if (!(u->flags & UMatData::USER_ALLOCATED) && u->origdata) {
+        release(u->origdata, u->size);
+    }
+    u->origdata = 0;
+    u->~UMatData();
+    release(u, sizeof(UMatData));
+}
+
+void PooledMatAllocator::drainThreadCache(vector<void*>* blocks, size_t& bytes) const {
+    lock_guard<mutex> lock(shared_lock);
+    for (int c = 0; c < kClassCount; c++) {
+        size_t class_size = classBytes(c);
+        for (void* block : blocks[c]) {
+            if (shared_bytes + class_size <= kSharedCacheBytes) {
+                shared_free[c].push_back(block);
+                shared_bytes += class_size;
+            } else {
+                fastFree(block);
+                system_frees++;
+            }
+        }
+        blocks[c].clear();
+    }
+    bytes = 0;
+}
+
+MatPoolStats PooledMatAllocator::stats() const {
+    MatPoolStats s;
+    s.allocations = allocations.load();
+    s.thread_hits = thread_hits.load();
+    s.shared_hits = shared_hits.load();
+    s.system_allocs = system_allocs.load();
+    s.system_frees = system_frees.load();
+    s.bytes_in_use = bytes_in_use.load();
+    s.peak_bytes = peak_bytes.load();
+    {
+        lock_guard<mutex> lock(shared_lock);
+        s.shared_cached = shared_bytes;
+    }
+    return s;
+}
+
+// ============================================================================
+// MatPoolScope
+// ============================================================================
+
+MatPoolScope::MatPoolScope() : previous(Mat::getDefaultAllocator()) {
+    Mat::setDefaultAllocator(&PooledMatAllocator::instance());
+}
+
+MatPoolScope::~MatPoolScope() {
+    Mat::setDefaultAllocator(previous);
+}
@@ -0,0 +1,96 @@
+/**
+ * 公式识别系统 - Mat 内存池头文件
+ * 按尺寸分级缓存 Mat 数据块的 cv::MatAllocator, 批量识别时各线程在图片之间复用缓冲区
+ */
+
+#ifndef MAT_POOL_H
+#define MAT_POOL_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+// 内存池统计
+struct MatPoolStats {
+    uint64_t allocations;      // 池申请次数(数据块与 UMatData 头, 不含用户提供的数据)
+    uint64_t thread_hits;      // 由本线程缓存满足
+    uint64_t shared_hits;      // 由共享缓存满足(如解码线程申请、识别线程释放的块)
+    uint64_t system_allocs;    // 向系统申请(fastMalloc)
+    uint64_t system_frees;     // 归还系统(缓存已满或超过最大分级)
+    uint64_t bytes_in_use;     // 当前被 Mat 占用的字节数(按分级尺寸计)
+    uint64_t peak_bytes;       // bytes_in_use 峰值
+    uint64_t shared_cached;    // 共享缓存中的空闲字节数
+};
+
+// 尺寸分级内存池分配器
+// - 分级: 64 字节起, 每个 2 的幂区间再分 4 级(浪费不超过 25%), 最大 64MB, 更大的直接走系统
+// - 每个线程一份无锁缓存(上限 kThreadCacheBytes), 满了放入加锁的共享缓存(上限 kSharedCacheBytes),
+//   再满才归还系统; 申请顺序相反
+// - UMatData 头也从池中分配, 稳定状态下一张图片的处理不再调用 malloc/free
+// - 进程级单例且永不析构: OpenCV 内部可能在退出时才释放池中分配的 Mat
+class PooledMatAllocator : public MatAllocator {
+public:
+    static const size_t kMinBlock = 64;
+    static const int kMinShift = 6;
+    static const int kMaxShift = 26;
+    static const int kClassCount = (kMaxShift - kMinShift) * 4 + 1;
+    static const size_t kThreadCacheBytes = 32u << 20;
+    static const size_t kSharedCacheBytes = 256u << 20;
+
+private:
+    mutable mutex shared_lock;
+    mutable vector<void*> shared_free[kClassCount];
+    mutable size_t shared_bytes;
+
+    mutable atomic<uint64_t> allocations;
+    mutable atomic<uint64_t> thread_hits;
+    mutable atomic<uint64_t> shared_hits;
+    mutable atomic<uint64_t> system_allocs;
+    mutable atomic<uint64_t> system_frees;
+    mutable atomic<uint64_t> bytes_in_use;
+    mutable atomic<uint64_t> peak_bytes;
+
+    PooledMatAllocator();
+
+    void* acquire(size_t size) const;
+    void release(void* block, size_t size) const;
+
+public:
+    static PooledMatAllocator& instance();
+
+    // 尺寸分级: 返回分级下标并给出分级尺寸; 超过最大分级返回 -1
+    static int sizeClass(size_t size, size_t& class_size);
+    static size_t classBytes(int c);
+
+    UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                       AccessFlag flags, UMatUsageFlags usage) const override;
+    bool allocate(UMatData* data, AccessFlag flags, UMatUsageFlags usage) const override;
+    void deallocate(UMatData* data) const override;
+
+    // 线程退出时把本线程缓存移入共享缓存
+    void drainThreadCache(vector<void*>* blocks, size_t& bytes) const;
+
+    MatPoolStats stats() const;
+};
+
+// RAII 安装: 构造时把内存池设为 OpenCV 默认分配器, 析构时恢复原分配器
+// OpenCV 的默认分配器是进程级的, 作用范围内所有线程新建的 Mat(含 imread、resize 等内部输出)都走内存池;
+// 已分配的 Mat 记录了自己的分配器, 恢复后释放仍回到内存池
+class MatPoolScope {
+private:
+    MatAllocator* previous;
+
+public:
+    MatPoolScope();
+    ~MatPoolScope();
+
+    MatPoolScope(const MatPoolScope&) = delete;
+    MatPoolScope& operator=(const MatPoolScope&) = delete;
+};
+
+#endif // MAT_POOL_H
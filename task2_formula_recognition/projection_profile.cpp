@@ -0,0 +1,57 @@
+/**
+ * 公式识别系统 - 投影轮廓实现文件
+ * 基于 cv::reduce 的行/列投影计算, 用于公式行检测与字符列预分割
+ */
+
+#include "projection_profile.h"
+
+// dim=1 按行求和(水平投影), dim=0 按列求和(垂直投影)
+// cv::reduce 对整块内存做向量化累加, 代替逐像素 at<uchar> 访问
+static vector<int> projection(const Mat& binary, const Rect& region, int dim) {
+    Mat roi = region.area() > 0 ? binary(region) : binary;
+
+    Mat sums;
+    reduce(roi, sums, dim, REDUCE_SUM, CV_32S);
+
+    // 前景像素值为255, 求和后除以255得到像素个数
+    const int* data = sums.ptr<int>();
+    vector<int> profile(data, data + sums.total());
+    for (auto& v : profile) {
+        v /= 255;
+    }
+    return profile;
+}
+
+vector<int> horizontalProjection(const Mat& binary, const Rect& region) {
+    return projection(binary, region, 1);
+}
+
+vector<int> verticalProjection(const Mat& binary, const Rect& region) {
+    return projection(binary, region, 0);
+}
+
+vector<Range> projectionRuns(const vector<int>& profile, int maxGap) {
+    vector<Range> runs;
+
+    int n = (int)profile.size();
+    int start = -1;
+    int lastInk = -1;
+
+    for (int i = 0; i < n; i++) {
+        if (profile[i] <= 0) continue;
+
+        if (start < 0) {
+            start = i;
+        } else if (i - lastInk - 1 > maxGap) {
+            runs.push_back(Range(start, lastInk + 1));
+            start = i;
+        }
+        lastInk = i;
+    }
+
+    if (start >= 0) {
+        runs.push_back(Range(start, lastInk + 1));
+    }
+
+    return runs;
+}
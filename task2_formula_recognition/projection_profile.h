@@ -0,0 +1,24 @@
+/**
+ * 公式识别系统 - 投影轮廓头文件
+ * 基于 cv::reduce 的行/列投影计算, 用于公式行检测与字符列预分割
+ */
+
+#ifndef PROJECTION_PROFILE_H
+#define PROJECTION_PROFILE_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+// 水平投影: region 内每行的前景像素数(binary 为 0/255 二值图, 空 region 表示整图)
+vector<int> horizontalProjection(const Mat& binary, const Rect& region = Rect());
+
+// 垂直投影: region 内每列的前景像素数
+vector<int> verticalProjection(const Mat& binary, const Rect& region = Rect());
+
+// 投影中的连续非零区间 [start, end); 间隔不超过 maxGap 的相邻区间合并为一个
+vector<Range> projectionRuns(const vector<int>& profile, int maxGap = 0);
+
+#endif // PROJECTION_PROFILE_H
@@ -0,0 +1,35 @@
+/**
+ * 公式识别系统 - 分阶段计时实现文件
+ * 记录单张图片各识别阶段的耗时, 随结果返回, 也可在批量处理中汇总
+ */
+
+#include "recognition_profile.h"
+
+static const char* kStageNames[STAGE_COUNT] = {
+    "preprocess", "row_detection", "segmentation", "classification", "evaluation", "rendering"
+};
+
+RecognitionProfile::RecognitionProfile() : images(0) {
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        stage_ms[s] = 0.0;
+    }
+}
+
+void RecognitionProfile::merge(const RecognitionProfile& other) {
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        stage_ms[s] += other.stage_ms[s];
+    }
+    images += other.images;
+}
+
+double RecognitionProfile::totalMs() const {
+    double total = 0.0;
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        total += stage_ms[s];
+    }
+    return total;
+}
+
+const char* RecognitionProfile::stageName(RecognitionStage stage) {
+    return kStageNames[stage];
+}
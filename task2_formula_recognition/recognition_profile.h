@@ -0,0 +1,63 @@
+/**
+ * 公式识别系统 - 分阶段计时头文件
+ * 记录单张图片各识别阶段的耗时, 随结果返回, 也可在批量处理中汇总
+ */
+
+#ifndef RECOGNITION_PROFILE_H
+#define RECOGNITION_PROFILE_H
+
+#include <chrono>
+#include <string>
+
+using namespace std;
+
+// 识别阶段
+enum RecognitionStage {
+    STAGE_PREPROCESS = 0,  // 灰度化、二值化、形态学、行分辨率归一化
+    STAGE_ROW_DETECTION,   // 公式行/区域检测(XY-cut)
+    STAGE_SEGMENTATION,    // 连通域标记与字形合并
+    STAGE_CLASSIFICATION,  // 字形缓存查询、规则级联、字形库匹配
+    STAGE_EVALUATION,      // 表达式计算
+    STAGE_RENDERING,       // 结果绘制与图片编码
+    STAGE_COUNT
+};
+
+// 各阶段累计耗时
+// 多公式识别的各行并发执行, 行内阶段耗时为各行之和(可能大于整张图片的墙钟时间)
+struct RecognitionProfile {
+    double stage_ms[STAGE_COUNT];
+    int images;            // 计入的图片数, 合并后用于求平均
+
+    RecognitionProfile();
+    void add(RecognitionStage stage, double ms) { stage_ms[stage] += ms; }
+    void merge(const RecognitionProfile& other);
+    double totalMs() const;
+
+    // 阶段名(JSON 键与统计输出共用)
+    static const char* stageName(RecognitionStage stage);
+};
+
+// RAII 阶段计时: profile 为空时不读时钟
+class StageTimer {
+private:
+    RecognitionProfile* profile;
+    RecognitionStage stage;
+    chrono::steady_clock::time_point start;
+
+public:
+    StageTimer(RecognitionProfile* p, RecognitionStage s) : profile(p), stage(s) {
+        if (profile) start = chrono::steady_clock::now();
+    }
+
+    ~StageTimer() {
+        if (profile) {
+            chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+            profile->add(stage, elapsed.count());
+        }
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+};
+
+#endif // RECOGNITION_PROFILE_H
@@ -0,0 +1,311 @@
+/**
+ * 公式识别系统 - 服务模式实现文件
+ * 常驻进程通过 Unix 域套接字或标准输入/输出接收识别请求, 以 JSON 返回结果
+ */
+
+#include "recognition_server.h"
+#include "formula_json.h"
+#include <cerrno>
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// ============================================================================
+// LineChannel 实现
+// ============================================================================
+
+LineChannel::LineChannel(int in, int out) : in_fd(in), out_fd(out), pos(0), len(0) {}
+
+bool LineChannel::fill() {
+    while (true) {
+        ssize_t n = ::read(in_fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            pos = 0;
+            len = (size_t)n;
+            return true;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        return false;
+    }
+}
+
+bool LineChannel::readLine(string& line) {
+    line.clear();
+    while (true) {
+        if (pos == len && !fill()) {
+            return !line.empty();
+        }
+        char* start = buffer + pos;
+        char* newline = static_cast<char*>(memchr(start, '\n', len - pos));
+        if (newline != nullptr) {
+            line.append(start, newline - start);
+            pos += (newline - start) + 1;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            return true;
+        }
+        line.append(start, len - pos);
+        pos = len;
+    }
+}
+
+bool LineChannel::readBytes(size_t n, vector<uchar>& data) {
+    data.resize(n);
+    size_t copied = 0;
+    while (copied < n) {
+        if (pos == len && !fill()) {
+            return false;
+        }
+        size_t chunk = min(n - copied, len - pos);
+        memcpy(data.data() + copied, buffer + pos, chunk);
+        pos += chunk;
+        copied += chunk;
+    }
+    return true;
+}
+
+bool LineChannel::writeAll(const char* data, size_t n) {
+    while (n > 0) {
+        ssize_t written = ::write(out_fd, data, n);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        n -= (size_t)written;
+    }
+    return true;
+}
+
+bool LineChannel::writeLine(const string& line) {
+    string out = line + "\n";
+    return writeAll(out.data(), out.size());
+}
+
+// ============================================================================
+// RecognitionServer 实现
+// ============================================================================
+
+ServerOptions::ServerOptions() : multi_mode(true), max_bytes(64u << 20), result_cache(nullptr) {}
+
+RecognitionServer::RecognitionServer(const FormulaRecognizer& rec, const ServerOptions& opts)
+    : recognizer(rec), options(opts), requests(0), expression_errors(0), stopping(false),
+      listen_fd(-1) {}
+
+static string errorJson(const string& message) {
+    return "{\"error\":\"" + jsonEscape(message) + "\"}";
+}
+
+string RecognitionServer::statsJson() const {
+    stringstream ss;
+    ss << "{\"requests\":" << requests.load()
+       << ",\"expression_errors\":" << expression_errors.load();
+    GlyphCacheStats cache;
+    if (recognizer.glyphCacheStats(cache)) {
+        ss << ",\"glyph_cache\":{\"hits\":" << cache.hits << ",\"misses\":" << cache.misses
+           << ",\"size\":" << cache.size << ",\"capacity\":" << cache.capacity << "}";
+    }
+    if (options.result_cache != nullptr) {
+        ResultCacheStats rc = options.result_cache->stats();
+        ss << ",\"result_cache\":{\"hits\":" << rc.hits << ",\"misses\":" << rc.misses
+           << ",\"stores\":" << rc.stores << ",\"evictions\":" << rc.evictions
+           << ",\"bytes\":" << rc.bytes << "}";
+    }
+    ss << "}";
+    return ss.str();
+}
+
+string RecognitionServer::handleRequest(const string& line, LineChannel& channel,
+                                        bool& close_after) {
+    stringstream ss(line);
+    string command;
+    ss >> command;
+
+    if (command == "ping") {
+        return "{\"ok\":true}";
+    }
+    if (command == "stats") {
+        return statsJson();
+    }
+    if (command == "shutdown") {
+        close_after = true;
+        stop();
+        return "{\"ok\":true}";
+    }
+    if (command != "path" && command != "bytes") {
+        return errorJson("未知命令: " + command);
+    }
+
+    // 命令后的 -- 选项, 剩余部分为参数
+    bool multi_mode = options.multi_mode;
+    string argument;
+    ss >> ws;
+    while (ss.peek() == '-') {
+        string opt;
+        ss >> opt >> ws;
+        if (opt == "--single") {
+            multi_mode = false;
+        } else if (opt == "--multi") {
+            multi_mode = true;
+        } else {
+            return errorJson("未知选项: " + opt);
+        }
+    }
+    getline(ss, argument);
+
+    requests++;
+    vector<uchar> data;
+    string image_name;
+
+    if (command == "path") {
+        image_name = argument;
+        if (!readFileBytes(argument, data) || data.empty()) {
+            return imageResultsToJson(image_name, vector<FormulaResult>(), "无法读取图像");
+        }
+    } else {
+        char* end = nullptr;
+        unsigned long long n = strtoull(argument.c_str(), &end, 10);
+        if (argument.empty() || *end != '\0' || n == 0 || n > options.max_bytes) {
+            // 长度不可信, 无法跳过后续字节, 关闭连接
+            close_after = true;
+            return errorJson("无效的字节数: " + argument);
+        }
+        if (!channel.readBytes((size_t)n, data)) {
+            close_after = true;
+            return errorJson("图片数据不完整");
+        }
+        image_name = "-";
+    }
+
+    string cache_key;
+    if (options.result_cache != nullptr) {
+        string cached;
+        cache_key = options.result_cache->keyFor(data, multi_mode);
+        if (options.result_cache->lookup(cache_key, cached)) {
+            return imageFormulasToJson(image_name, cached);
+        }
+    }
+
+    Mat image = imdecode(data, IMREAD_COLOR);
+    if (image.empty()) {
+        return imageResultsToJson(image_name, vector<FormulaResult>(), "无法解码图像");
+    }
+
+    vector<FormulaResult> results;
+    if (multi_mode) {
+        results = recognizer.recognizeMultipleFormulas(image);
+    } else {
+        results.push_back(recognizer.recognizeFormula(image));
+    }
+    for (const auto& result : results) {
+        if (!result.error.empty()) expression_errors++;
+    }
+    if (!cache_key.empty()) {
+        options.result_cache->store(cache_key, formulasToJson(results));
+    }
+    return imageResultsToJson(image_name, results);
+}
+
+void RecognitionServer::serveConnection(int in_fd, int out_fd) {
+    LineChannel channel(in_fd, out_fd);
+    string line;
+    while (!stopping && channel.readLine(line)) {
+        if (line.empty()) continue;
+
+        bool close_after = false;
+        string response = handleRequest(line, channel, close_after);
+        if (!channel.writeLine(response) || close_after) {
+            break;
+        }
+    }
+}
+
+void RecognitionServer::stop() {
+    stopping = true;
+    if (listen_fd >= 0) {
+        // 唤醒阻塞在 accept 上的主线程
+        ::shutdown(listen_fd, SHUT_RDWR);
+    }
+    lock_guard<mutex> guard(connections_lock);
+    for (int fd : connections) {
+        ::shutdown(fd, SHUT_RDWR);
+    }
+}
+
+int RecognitionServer::run() {
+    if (options.socket_path.empty()) {
+        clog << "服务模式: 标准输入/输出" << endl;
+        serveConnection(STDIN_FILENO, STDOUT_FILENO);
+        return 0;
+    }
+
+    // 客户端断开时写入不应终止进程
+    signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (options.socket_path.size() >= sizeof(addr.sun_path)) {
+        cerr << "错误: 套接字路径过长: " << options.socket_path << endl;
+        return -1;
+    }
+    strncpy(addr.sun_path, options.socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        cerr << "错误: 无法创建套接字: " << strerror(errno) << endl;
+        return -1;
+    }
+    ::unlink(options.socket_path.c_str());
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listen_fd, 64) < 0) {
+        cerr << "错误: 无法监听 " << options.socket_path << ": " << strerror(errno) << endl;
+        ::close(listen_fd);
+        listen_fd = -1;
+        return -1;
+    }
+
+    clog << "服务模式: 监听 " << options.socket_path << endl;
+
+    while (!stopping) {
+        int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        {
+            lock_guard<mutex> guard(connections_lock);
+            if (stopping) {
+                ::close(fd);
+                break;
+            }
+            connections.push_back(fd);
+        }
+        // 连接线程结束时自行关闭并注销连接, 长时间运行不累积线程和描述符
+        thread([this, fd]() {
+            serveConnection(fd, fd);
+            lock_guard<mutex> guard(connections_lock);
+            connections.erase(find(connections.begin(), connections.end(), fd));
+            ::close(fd);
+            connections_done.notify_all();
+        }).detach();
+    }
+
+    stop();
+    {
+        unique_lock<mutex> guard(connections_lock);
+        connections_done.wait(guard, [this]() { return connections.empty(); });
+    }
+    ::close(listen_fd);
+    listen_fd = -1;
+    ::unlink(options.socket_path.c_str());
+
+    clog << "服务已停止, 共处理 " << requests.load() << " 个请求" << endl;
+    return 0;
+}
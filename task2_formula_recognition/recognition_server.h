@@ -0,0 +1,83 @@
+/**
+ * 公式识别系统 - 服务模式头文件
+ * 常驻进程通过 Unix 域套接字或标准输入/输出接收识别请求, 以 JSON 返回结果
+ */
+
+#ifndef RECOGNITION_SERVER_H
+#define RECOGNITION_SERVER_H
+
+#include "formula_recognizer.h"
+#include "result_cache.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// 行协议(每个请求一行, 每个响应一行 JSON):
+//   path [--single] <图片路径>      识别磁盘上的图片(路径为行内剩余部分, 可含空格)
+//   bytes [--single] <字节数>       请求行之后紧跟给定字节数的已编码图片(PNG/JPG 等)
+//   stats                           已处理请求数与字形缓存统计
+//   ping                            存活检查
+//   shutdown                        停止服务(套接字模式下关闭所有连接)
+
+// 带缓冲的文件描述符读写(套接字、管道、标准输入/输出通用)
+class LineChannel {
+private:
+    int in_fd;
+    int out_fd;
+    char buffer[65536];
+    size_t pos;
+    size_t len;
+
+    bool fill();
+
+public:
+    LineChannel(int in_fd, int out_fd);
+
+    // 读取一行(去掉行尾 \r\n), 连接关闭时返回 false
+    bool readLine(string& line);
+    // 读取恰好 n 个字节
+    bool readBytes(size_t n, vector<uchar>& data);
+    bool writeAll(const char* data, size_t n);
+    bool writeLine(const string& line);
+};
+
+// 服务选项
+struct ServerOptions {
+    string socket_path;    // Unix 域套接字路径, 为空时使用标准输入/输出
+    bool multi_mode;       // 默认识别模式(请求可用 --single 覆盖)
+    size_t max_bytes;      // bytes 请求允许的最大图片字节数
+    ResultCache* result_cache;  // 磁盘结果缓存(为空时不使用)
+
+    ServerOptions();
+};
+
+// 识别服务: 识别器与字形缓存在进程生命周期内保持预热, 每个连接一个线程
+class RecognitionServer {
+private:
+    const FormulaRecognizer& recognizer;  // 共享识别器(可并发调用)
+    ServerOptions options;
+    atomic<uint64_t> requests;
+    atomic<uint64_t> expression_errors;   // 识别出但无法解析/计算的公式数
+    atomic<bool> stopping;
+    int listen_fd;
+    mutex connections_lock;
+    condition_variable connections_done;
+    vector<int> connections;              // 活动连接, 停止时统一断开
+
+    void serveConnection(int in_fd, int out_fd);
+    string handleRequest(const string& line, LineChannel& channel, bool& close_after);
+    string statsJson() const;
+    void stop();
+
+public:
+    RecognitionServer(const FormulaRecognizer& recognizer, const ServerOptions& options);
+
+    // 阻塞运行, 直到标准输入关闭、收到 shutdown 或监听失败; 返回进程退出码
+    int run();
+};
+
+#endif // RECOGNITION_SERVER_H
@@ -0,0 +1,203 @@
+/**
+ * 公式识别系统 - 结果缓存实现文件
+ * 以图片文件内容哈希为键的磁盘结果缓存, 命中时跳过解码与识别
+ */
+
+#include "result_cache.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <sstream>
+#include <thread>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+// 淘汰后保留的占用比例
+static const double kEvictTarget = 0.8;
+
+bool readFileBytes(const string& path, vector<unsigned char>& data) {
+    ifstream in(path, ios::binary);
+    if (!in.is_open()) return false;
+
+    in.seekg(0, ios::end);
+    streamoff size = in.tellg();
+    if (size < 0) return false;
+    in.seekg(0, ios::beg);
+
+    data.resize((size_t)size);
+    return size == 0 || (bool)in.read(reinterpret_cast<char*>(data.data()), size);
+}
+
+ResultCache::ResultCache(const string& d, uint64_t max, const string& cfg)
+    : dir(d), max_bytes(max), config(cfg), bytes(0), hits(0), misses(0), stores(0), evictions(0) {
+    while (dir.size() > 1 && dir.back() == '/') dir.pop_back();
+}
+
+bool ResultCache::open() {
+    if (::mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        return false;
+    }
+    struct stat st;
+    if (stat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+        return false;
+    }
+    bytes = scan(nullptr);
+    return true;
+}
+
+uint64_t ResultCache::hashBytes(const void* data, size_t size, uint64_t seed) {
+    const uint64_t kMul = 0x9E3779B97F4A7C15ULL;
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint64_t h = seed ^ (size * kMul);
+
+    while (size >= 8) {
+        uint64_t k;
+        memcpy(&k, p, 8);
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        h = (h ^ k) * kMul;
+        h ^= h >> 29;
+        p += 8;
+        size -= 8;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, p, size);
+    h = (h ^ (tail * 0xc4ceb9fe1a85ec53ULL)) * kMul;
+
+    // murmur3 fmix64
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+string ResultCache::keyFor(const vector<unsigned char>& file_bytes, bool multi_mode) const {
+    string variant = config + (multi_mode ? "/multi" : "/single");
+    uint64_t seed = hashBytes(variant.data(), variant.size(), 0);
+    uint64_t h = hashBytes(file_bytes.data(), file_bytes.size(), seed);
+
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx", (unsigned long long)h);
+    return key;
+}
+
+string ResultCache::entryPath(const string& key) const {
+    return dir + "/" + key.substr(0, 2) + "/" + key + ".json";
+}
+
+bool ResultCache::lookup(const string& key, string& formulas_json) {
+    string path = entryPath(key);
+    ifstream in(path, ios::binary);
+    if (!in.is_open()) {
+        misses++;
+        return false;
+    }
+    formulas_json.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    if (formulas_json.empty()) {
+        misses++;
+        return false;
+    }
+
+    // 刷新修改时间, 淘汰时按最近使用排序
+    ::utime(path.c_str(), nullptr);
+    hits++;
+    return true;
+}
+
+void ResultCache::store(const string& key, const string& formulas_json) {
+    string subdir = dir + "/" + key.substr(0, 2);
+    ::mkdir(subdir.c_str(), 0755);
+
+    // 临时文件名带进程号与线程号, 写完后原子 rename
+    stringstream tmp;
+    tmp << entryPath(key) << ".tmp." << getpid() << "." << hash<thread::id>()(this_thread::get_id());
+    string tmp_path = tmp.str();
+    {
+        ofstream out(tmp_path, ios::binary);
+        if (!out.is_open()) return;
+        out << formulas_json;
+        if (!out.good()) {
+            out.close();
+            ::unlink(tmp_path.c_str());
+            return;
+        }
+    }
+    if (::rename(tmp_path.c_str(), entryPath(key).c_str()) != 0) {
+        ::unlink(tmp_path.c_str());
+        return;
+    }
+
+    stores++;
+    if ((bytes += formulas_json.size()) > max_bytes) {
+        evict();
+    }
+}
+
+// 遍历缓存目录, 返回总字节数; entries 非空时收集 ((修改时间, 大小), 路径)
+uint64_t ResultCache::scan(vector<pair<pair<int64_t, uint64_t>, string>>* entries) const {
+    uint64_t total = 0;
+    DIR* top = opendir(dir.c_str());
+    if (top == nullptr) return 0;
+
+    struct dirent* sub;
+    while ((sub = readdir(top)) != nullptr) {
+        if (sub->d_name[0] == '.') continue;
+        string subdir = dir + "/" + sub->d_name;
+        DIR* d = opendir(subdir.c_str());
+        if (d == nullptr) continue;
+
+        struct dirent* e;
+        while ((e = readdir(d)) != nullptr) {
+            string name = e->d_name;
+            if (name.size() < 5 || name.compare(name.size() - 5, 5, ".json") != 0) continue;
+            string path = subdir + "/" + name;
+            struct stat st;
+            if (stat(path.c_str(), &st) != 0) continue;
+            total += (uint64_t)st.st_size;
+            if (entries != nullptr) {
+                entries->push_back(make_pair(make_pair((int64_t)st.st_mtime, (uint64_t)st.st_size), path));
+            }
+        }
+        closedir(d);
+    }
+    closedir(top);
+    return total;
+}
+
+void ResultCache::evict() {
+    // 其他线程正在淘汰时直接返回
+    unique_lock<mutex> lock(evict_lock, try_to_lock);
+    if (!lock.owns_lock()) return;
+
+    vector<pair<pair<int64_t, uint64_t>, string>> entries;
+    uint64_t total = scan(&entries);
+    uint64_t target = (uint64_t)(max_bytes * kEvictTarget);
+
+    sort(entries.begin(), entries.end());
+    for (const auto& entry : entries) {
+        if (total <= target) break;
+        if (::unlink(entry.second.c_str()) == 0) {
+            total -= entry.first.second;
+            evictions++;
+        }
+    }
+    bytes = total;
+}
+
+ResultCacheStats ResultCache::stats() const {
+    ResultCacheStats s;
+    s.hits = hits;
+    s.misses = misses;
+    s.stores = stores;
+    s.evictions = evictions;
+    s.bytes = bytes;
+    return s;
+}
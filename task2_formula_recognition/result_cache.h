@@ -0,0 +1,67 @@
+/**
+ * 公式识别系统 - 结果缓存头文件
+ * 以图片文件内容哈希为键的磁盘结果缓存, 命中时跳过解码与识别
+ */
+
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// 缓存统计
+struct ResultCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stores;
+    uint64_t evictions;
+    uint64_t bytes;        // 估计的缓存占用
+};
+
+// 磁盘结果缓存: <目录>/<键前2位>/<键>.json, 内容为公式结果 JSON 数组
+// - 键 = 图片文件原始字节的 64 位哈希, 以识别器版本、字形库与识别模式为种子, 任一变化即不再命中
+// - 写入先写临时文件再 rename, 多个线程/进程并发读写不会读到半个文件
+// - 命中时更新文件修改时间; 占用超过上限时按修改时间淘汰最久未用的条目, 降到上限的 80%
+class ResultCache {
+private:
+    string dir;
+    uint64_t max_bytes;
+    string config;                 // 识别器配置指纹
+    atomic<uint64_t> bytes;
+    atomic<uint64_t> hits;
+    atomic<uint64_t> misses;
+    atomic<uint64_t> stores;
+    atomic<uint64_t> evictions;
+    mutex evict_lock;              // 同一时刻只有一个线程扫描淘汰
+
+    string entryPath(const string& key) const;
+    uint64_t scan(vector<pair<pair<int64_t, uint64_t>, string>>* entries) const;
+    void evict();
+
+public:
+    ResultCache(const string& dir, uint64_t max_bytes, const string& config);
+
+    // 创建目录并统计现有占用, 失败返回 false
+    bool open();
+
+    // 64 位内容哈希(每次处理 8 字节)
+    static uint64_t hashBytes(const void* data, size_t size, uint64_t seed);
+
+    // 图片文件字节 + 识别模式 -> 缓存键(16 位十六进制)
+    string keyFor(const vector<unsigned char>& file_bytes, bool multi_mode) const;
+
+    bool lookup(const string& key, string& formulas_json);
+    void store(const string& key, const string& formulas_json);
+
+    ResultCacheStats stats() const;
+};
+
+// 读取整个文件, 失败返回 false
+bool readFileBytes(const string& path, vector<unsigned char>& data);
+
+#endif // RESULT_CACHE_H